@@ -8,7 +8,8 @@ import Graphic from './assets/gaminggraphic.svg'
 import AlgorithmIcon from './assets/algorithm.svg'
 import StopwatchIcon from './assets/stopwatch.svg'
 
-const API_BASE = import.meta.env.VITE_API_URL || 'http://localhost:8080';
+// an empty VITE_API_URL means same origin, i.e. the bundle is served by steam_server itself
+const API_BASE = import.meta.env.VITE_API_URL ?? 'http://localhost:8080';
 
 function App() {
     const [activeAlgorithm, setActiveAlgorithm] = useState('Default');
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Runs a sharded catalog on this machine: N steam_server shards on ports 9001.. and a
+# steam_coordinator in front of them on PORT (default 8080). Ctrl-C stops everything.
+#
+#   scripts/local_cluster.sh [shards] [data dir]
+#   scripts/local_cluster.sh 4 data/synthetic
+set -euo pipefail
+
+SHARD_COUNT=${1:-2}
+DATA=${2:-data}
+BASE_PORT=${SHARD_BASE_PORT:-9001}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+pids=()
+trap 'kill "${pids[@]}" 2>/dev/null; wait' EXIT INT TERM
+
+shard_list=""
+for ((i = 0; i < SHARD_COUNT; i++)); do
+    port=$((BASE_PORT + i))
+    SHARD="$i/$SHARD_COUNT" DATA_DIR="$DATA" PORT=$port LOG_LEVEL=warning "$ROOT/steam_server" > "shard_$i.log" 2>&1 &
+    pids+=($!)
+    shard_list+="${shard_list:+,}127.0.0.1:$port"
+done
+
+# shards answer once their slice is loaded
+for ((i = 0; i < SHARD_COUNT; i++)); do
+    until curl -sf -o /dev/null "http://127.0.0.1:$((BASE_PORT + i))/metrics"; do
+        kill -0 "${pids[$i]}" 2>/dev/null || { echo "shard $i exited, see shard_$i.log" >&2; exit 1; }
+        sleep 0.2
+    done
+done
+
+SHARDS=$shard_list "$ROOT/steam_coordinator" &
+pids+=($!)
+wait -n
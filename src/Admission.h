@@ -0,0 +1,133 @@
+#ifndef STEAMSEARCH_ADMISSION_H
+#define STEAMSEARCH_ADMISSION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Worker threads that all scan gates together may hold, running or queued. A gate takes a unit
+// before it admits or queues a request, so a spike spread over every route still leaves the
+// remaining workers to /search and the cheap routes.
+class AdmissionBudget {
+public:
+    explicit AdmissionBudget(int capacity) : capacity(capacity) {}
+
+    bool tryTake() {
+        int current = used.load(std::memory_order_relaxed);
+        while (current < capacity) {
+            if (used.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel)) return true;
+        }
+        return false;
+    }
+
+    void give() { used.fetch_sub(1, std::memory_order_acq_rel); }
+
+    int inUse() const { return used.load(std::memory_order_relaxed); }
+
+    const int capacity;
+
+private:
+    std::atomic<int> used{0};
+};
+
+// Concurrency limit for one expensive route: at most maxActive requests run, at most maxQueued
+// wait, and nobody waits longer than maxWait. Everything else is rejected straight away so the
+// caller can answer 503 instead of piling more work onto the worker threads. With a budget every
+// running or waiting request also holds one of its units.
+class AdmissionGate {
+public:
+    AdmissionGate(std::string name, int maxActive, int maxQueued, std::chrono::milliseconds maxWait,
+                  AdmissionBudget* budget = nullptr)
+        : name(std::move(name)), maxActive(maxActive), maxQueued(maxQueued), maxWait(maxWait), budget(budget) {}
+
+    bool acquire() {
+        if (budget && !budget->tryTake()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            rejectedBudget++;
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (active < maxActive) {
+            active++;
+            admitted++;
+            return true;
+        }
+        if (queued >= maxQueued) {
+            rejectedQueueFull++;
+            if (budget) budget->give();
+            return false;
+        }
+
+        queued++;
+        bool ready = slotFree.wait_for(lock, maxWait, [this] { return active < maxActive; });
+        queued--;
+        if (!ready) {
+            rejectedTimeout++;
+            if (budget) budget->give();
+            return false;
+        }
+        active++;
+        admitted++;
+        return true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+        }
+        if (budget) budget->give();
+        slotFree.notify_one();
+    }
+
+    struct Stats {
+        int active, queued;
+        uint64_t admitted, rejectedQueueFull, rejectedTimeout, rejectedBudget;
+    };
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {active, queued, admitted, rejectedQueueFull, rejectedTimeout, rejectedBudget};
+    }
+
+    const std::string name;
+
+private:
+    int maxActive;
+    int maxQueued;
+    std::chrono::milliseconds maxWait;
+    AdmissionBudget* budget;
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    int active = 0;
+    int queued = 0;
+    uint64_t admitted = 0;
+    uint64_t rejectedQueueFull = 0;
+    uint64_t rejectedTimeout = 0;
+    uint64_t rejectedBudget = 0;
+};
+
+// Holds a slot for the lifetime of a scan
+class AdmissionTicket {
+public:
+    explicit AdmissionTicket(AdmissionGate& gate) : gate(gate), granted(gate.acquire()) {}
+    ~AdmissionTicket() {
+        if (granted) gate.release();
+    }
+
+    AdmissionTicket(const AdmissionTicket&) = delete;
+    AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+    explicit operator bool() const { return granted; }
+
+private:
+    AdmissionGate& gate;
+    bool granted;
+};
+
+#endif //STEAMSEARCH_ADMISSION_H
@@ -0,0 +1,921 @@
+#ifndef STEAMSEARCH_CATALOG_H
+#define STEAMSEARCH_CATALOG_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "CompactGame.h"
+#include "Hash.h"
+#include "ResultStore.h"
+#include "TagVotes.h"
+#include "JsonWriter.h"
+#include "MsgPackWriter.h"
+#include "Metrics.h"
+
+// The in-memory catalog and everything that scores it: loading, indexes, similarity kernels, the
+// catalog scan and result rendering. steam_server and the benchmarks both build on it, so nothing
+// in here may depend on Crow.
+
+using json = nlohmann::json;
+
+inline std::vector<CompactGame> globalGames;
+inline std::vector<char> globalStringPool;
+inline std::unordered_map<uint32_t, int> globalIndexById;
+
+// Content hash of everything loaded, changes whenever the dataset does (part of every ETag)
+inline uint64_t globalDatasetVersion = 0;
+
+// Where the loaded games sit in the whole catalog. A full load is one range, a shard (SHARD=i/N)
+// holds every Nth games_*.bin file and one range per file, in catalog order.
+struct CatalogRange {
+    size_t catalogStart;
+    size_t localStart;
+    size_t count;
+};
+inline std::vector<CatalogRange> globalCatalogRanges;
+inline size_t globalCatalogSize = 0;
+
+// Pre-serialized JSON values of each game's static fields, built once at load time and stored back
+// to back in one arena: id, imageURL, name, price, tagBits. The arena passes 4 GB somewhere above
+// 20M games, so offsets are 64 bit.
+struct GameFragment {
+    uint64_t offset;
+    uint32_t imageUrlLength, nameLength;
+    uint8_t idLength, priceLength, tagBitsLength; // at most 10, 24 and 89 bytes
+
+    const char* id() const;
+    const char* imageUrl() const { return id() + idLength; }
+    const char* name() const { return imageUrl() + imageUrlLength; }
+    const char* price() const { return name() + nameLength; }
+    const char* tagBits() const { return price() + priceLength; }
+};
+inline std::string globalFragmentArena;
+inline std::vector<GameFragment> globalFragments;
+
+inline const char* GameFragment::id() const { return globalFragmentArena.data() + offset; }
+
+// Normalized tag votes from tagvotes.bin (empty when the side file is missing)
+inline std::vector<uint32_t> globalVoteOffsets;
+inline std::vector<TagWeight> globalVotes;
+inline std::vector<uint32_t> globalVoteTotal;
+
+// Columnar copies of the filterable fields, a predicate pass touches a few MB instead of every 1.2 KB record
+inline std::vector<float> globalPrice;
+inline std::vector<float> globalReview;
+inline std::vector<int16_t> globalMetacritic;
+
+// Developer / publisher string pool offsets. The converter interns every string, so equal offsets
+// mean equal names and these double as integer ids (0 = unknown)
+inline std::vector<uint32_t> globalDeveloper;
+inline std::vector<uint32_t> globalPublisher;
+
+// tagBits copied out of the records, 8 words per game
+inline std::vector<uint32_t> globalTagBits;
+
+// Prefilter bitmaps: bit i of a column's bitmap k is set when game i has value <= cuts[k].
+// A filter threshold maps to the nearest cut as a superset, then survivors get the exact check.
+struct ColumnBitmaps {
+    std::vector<float> cuts;
+    std::vector<std::vector<uint64_t>> lessEqual;
+};
+
+inline ColumnBitmaps priceBitmaps{{0.0f, 1.0f, 2.0f, 5.0f, 10.0f, 15.0f, 20.0f, 30.0f, 40.0f, 60.0f}, {}};
+inline ColumnBitmaps reviewBitmaps{{0.0f, 0.5f, 0.6f, 0.7f, 0.75f, 0.8f, 0.85f, 0.9f, 0.95f}, {}};
+inline ColumnBitmaps metacriticBitmaps{{0.0f, 50.0f, 60.0f, 70.0f, 75.0f, 80.0f, 85.0f, 90.0f}, {}};
+
+// Per-request measurements, reset by the RequestMetrics middleware and reported once the
+// handler returns. Crow runs a request's middleware and handler on the same thread.
+struct RequestTrace {
+    int series = 0;
+    std::chrono::steady_clock::time_point start;
+    uint32_t appId = 0;
+    uint64_t candidates = 0;
+    uint64_t results = 0;
+    double stageSeconds[(int)Stage::COUNT] = {};
+};
+
+inline thread_local RequestTrace currentTrace;
+
+// Adds the time spent in its scope to one stage of the current request
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        currentTrace.stageSeconds[(int)stage] += elapsed.count();
+    }
+
+private:
+    Stage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+inline float roundToTwo(float val) {
+    return std::round(val * 100.0f) / 100.0f;
+}
+
+inline const char* getString(uint32_t offset) {
+    if (offset >= globalStringPool.size()) return "";
+    return &globalStringPool[offset];
+}
+
+// Formats every game's static fields once. Strings are escaped by nlohmann itself and numbers use
+// the writer's dump() compatible formatting, so responses only copy bytes. Invalid UTF-8 is
+// replaced with U+FFFD instead of failing the whole response.
+inline void buildFragments() {
+    globalFragmentArena.clear();
+    globalFragments.resize(globalGames.size());
+
+    JsonWriter w(globalFragmentArena);
+    auto mark = [](size_t start) { return (uint32_t)(globalFragmentArena.size() - start); };
+
+    for (size_t i = 0; i < globalGames.size(); i++) {
+        const auto& g = globalGames[i];
+        auto& f = globalFragments[i];
+        f.offset = globalFragmentArena.size();
+
+        size_t start = globalFragmentArena.size();
+        w.integer(g.id);
+        f.idLength = (uint8_t)mark(start);
+
+        start = globalFragmentArena.size();
+        globalFragmentArena += json(getString(g.imageUrlOffset)).dump(-1, ' ', false, json::error_handler_t::replace);
+        f.imageUrlLength = mark(start);
+
+        start = globalFragmentArena.size();
+        globalFragmentArena += json(getString(g.nameOffset)).dump(-1, ' ', false, json::error_handler_t::replace);
+        f.nameLength = mark(start);
+
+        start = globalFragmentArena.size();
+        w.number(roundToTwo(g.price));
+        f.priceLength = (uint8_t)mark(start);
+
+        start = globalFragmentArena.size();
+        w.raw('[');
+        for (int j = 0; j < 8; j++) {
+            if (j) w.raw(',');
+            w.integer(g.tagBits[j]);
+        }
+        w.raw(']');
+        f.tagBitsLength = (uint8_t)mark(start);
+    }
+    globalFragmentArena.shrink_to_fit();
+
+    std::cout << "Built " << globalFragmentArena.size() << " bytes of response fragments" << std::endl;
+}
+
+// index into globalGames, or -1 when the id is not in the catalog
+inline int findGame(uint32_t id) {
+    StageTimer timer(Stage::LOOKUP);
+    auto it = globalIndexById.find(id);
+    return it == globalIndexById.end() ? -1 : it->second;
+}
+
+// Optional side file for /recommend/wjaccard, without it the route falls back to tagBits Jaccard.
+// Covers the whole catalog, a shard reads only the entries of its own ranges.
+inline void loadTagVotes(const std::string& path) {
+    globalVoteOffsets.clear();
+    globalVotes.clear();
+    globalVoteTotal.clear();
+
+    std::ifstream vFile(path, std::ios::binary | std::ios::ate);
+    if (!vFile.is_open()) {
+        std::cerr << "WARNING: Could not find " << path << ", weighted jaccard uses tag bits" << std::endl;
+        return;
+    }
+
+    std::streamsize vSize = vFile.tellg();
+    vFile.seekg(0, std::ios::beg);
+
+    uint32_t gameCount = 0;
+    vFile.read((char*)&gameCount, sizeof(gameCount));
+    if (gameCount != globalCatalogSize) {
+        std::cerr << "WARNING: " << path << " has " << gameCount << " games, expected " << globalCatalogSize << std::endl;
+        return;
+    }
+
+    std::vector<uint32_t> offsets(gameCount + 1);
+    vFile.read((char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    std::streamoff entriesStart = sizeof(uint32_t) * (gameCount + 2);
+    size_t entryBytes = (size_t)vSize - entriesStart;
+    if (!vFile || entryBytes != offsets.back() * sizeof(TagWeight)) {
+        std::cerr << "WARNING: " << path << " is truncated" << std::endl;
+        return;
+    }
+
+    std::vector<uint32_t> localOffsets;
+    localOffsets.reserve(globalGames.size() + 1);
+    localOffsets.push_back(0);
+    for (const auto& range : globalCatalogRanges) {
+        uint32_t first = offsets[range.catalogStart];
+        uint32_t last = offsets[range.catalogStart + range.count];
+        size_t base = globalVotes.size();
+        globalVotes.resize(base + (last - first));
+        vFile.seekg(entriesStart + (std::streamoff)first * sizeof(TagWeight), std::ios::beg);
+        vFile.read((char*)(globalVotes.data() + base), (std::streamsize)(last - first) * sizeof(TagWeight));
+        for (size_t i = 1; i <= range.count; i++) localOffsets.push_back((uint32_t)base + offsets[range.catalogStart + i] - first);
+    }
+    if (!vFile) {
+        std::cerr << "WARNING: " << path << " is truncated" << std::endl;
+        globalVotes.clear();
+        return;
+    }
+    globalVoteOffsets = std::move(localOffsets);
+
+    // per game weight sums so the kernel only has to find the intersection
+    globalVoteTotal.assign(globalGames.size(), 0);
+    for (size_t i = 0; i < globalGames.size(); i++) {
+        for (uint32_t e = globalVoteOffsets[i]; e < globalVoteOffsets[i + 1]; e++) globalVoteTotal[i] += globalVotes[e].weight;
+    }
+
+    std::cout << "Loaded " << globalVotes.size() << " tag votes from " << path << std::endl;
+}
+
+// Loads the catalog from dataDir, or from the first of the usual locations holding games_1.bin.
+// With shardCount > 1 only the files games_k.bin with (k - 1) % shardCount == shardIndex are kept.
+inline void loadData(const std::string& dataDir = "", int shardIndex = 0, int shardCount = 1) {
+
+    std::vector<std::string> possiblePaths = {"data/", "src/data/", "../src/data/"};
+    std::string foundPath = "data/";
+
+    // Determine which directory actually contains our data
+    for (const auto& p : possiblePaths) {
+        std::ifstream check(p + "games_1.bin");
+        if (check.good()) {
+            foundPath = p;
+            break;
+        }
+    }
+    if (!dataDir.empty()) foundPath = dataDir.back() == '/' ? dataDir : dataDir + "/";
+
+    // shards are games_1.bin, games_2.bin, ... up to the first one that is missing. Their sizes are
+    // summed first so a large catalog is read into one allocation instead of being regrown per shard
+    std::vector<std::string> gameFiles;
+    size_t totalGames = 0;
+    globalCatalogRanges.clear();
+    globalCatalogSize = 0;
+    for (int shard = 1;; shard++) {
+        std::string path = foundPath + "games_" + std::to_string(shard) + ".bin";
+        std::ifstream check(path, std::ios::binary | std::ios::ate);
+        if (!check.is_open()) break;
+        size_t count = (size_t)check.tellg() / sizeof(CompactGame);
+        if ((shard - 1) % shardCount == shardIndex) {
+            globalCatalogRanges.push_back({globalCatalogSize, totalGames, count});
+            totalGames += count;
+            gameFiles.push_back(path);
+        }
+        globalCatalogSize += count;
+    }
+    if (globalCatalogSize == 0) std::cerr << "ERROR: Could not find " << foundPath << "games_1.bin!" << std::endl;
+
+    globalGames.clear();
+    globalGames.reserve(totalGames);
+
+    for (const auto& path : gameFiles) {
+        std::ifstream gFile(path, std::ios::binary | std::ios::ate);
+
+        std::streamsize gSize = gFile.tellg();
+        gFile.seekg(0, std::ios::beg);
+
+        size_t numGamesInFile = gSize / sizeof(CompactGame);
+        size_t currentSize = globalGames.size();
+
+        globalGames.resize(currentSize + numGamesInFile);
+        gFile.read((char*)&globalGames[currentSize], numGamesInFile * sizeof(CompactGame));
+        gFile.close();
+
+        std::cout << "Loaded " << numGamesInFile << " games from " << path << std::endl;
+    }
+
+    std::string stringsPath = foundPath + "strings.bin";
+    std::ifstream sFile(stringsPath, std::ios::binary | std::ios::ate);
+
+    if (!sFile.is_open()) {
+        std::cerr << "ERROR: Could not find " << stringsPath << "!" << std::endl;
+        return;
+    }
+
+    std::streamsize sSize = sFile.tellg();
+    sFile.seekg(0, std::ios::beg);
+    globalStringPool.resize(sSize);
+    sFile.read(globalStringPool.data(), sSize);
+    sFile.close();
+
+    std::cout << "Successfully loaded total of " << globalGames.size() << " games into RAM." << std::endl;
+    if (shardCount > 1) {
+        std::cout << "Shard " << shardIndex << "/" << shardCount << " of a " << globalCatalogSize << " game catalog" << std::endl;
+    }
+    std::cout << "Successfully loaded " << sSize << " bytes into String Pool." << std::endl;
+
+    loadTagVotes(foundPath + "tagvotes.bin");
+
+    globalDatasetVersion = hashWords(globalGames.data(), globalGames.size() * sizeof(CompactGame));
+    globalDatasetVersion = hashWords(globalStringPool.data(), globalStringPool.size(), globalDatasetVersion);
+    globalDatasetVersion = hashWords(globalVotes.data(), globalVotes.size() * sizeof(TagWeight), globalDatasetVersion);
+    std::cout << "Dataset version " << std::hex << globalDatasetVersion << std::dec << std::endl;
+
+    std::cout << "--- Data Verification (First 5 Games) ---" << std::endl;
+    for (int i = 0; i < std::min((int)globalGames.size(), 5); i++) {
+        const char* name = getString(globalGames[i].nameOffset);
+        std::cout << "Index " << i << " | ID: " << globalGames[i].id
+                  << " | Name: [" << (name ? name : "NULL") << "]" << std::endl;
+    }
+    std::cout << "-----------------------------------------" << std::endl;
+}
+
+template <typename T>
+inline void buildBitmaps(ColumnBitmaps& bitmaps, const std::vector<T>& column) {
+    size_t words = (column.size() + 63) / 64;
+    bitmaps.lessEqual.assign(bitmaps.cuts.size(), std::vector<uint64_t>(words, 0));
+
+    for (size_t k = 0; k < bitmaps.cuts.size(); k++) {
+        auto& bits = bitmaps.lessEqual[k];
+        for (size_t i = 0; i < column.size(); i++) {
+            if ((float)column[i] <= bitmaps.cuts[k]) bits[i / 64] |= (1ULL << (i % 64));
+        }
+    }
+}
+
+// builds the id index, the filter columns and their prefilter bitmaps once the games are in RAM
+inline void buildIndexes() {
+    size_t n = globalGames.size();
+    globalIndexById.clear();
+    globalIndexById.reserve(n);
+    for (size_t i = 0; i < n; i++) globalIndexById.emplace(globalGames[i].id, (int)i);
+
+    globalPrice.resize(n);
+    globalReview.resize(n);
+    globalMetacritic.resize(n);
+    globalDeveloper.resize(n);
+    globalPublisher.resize(n);
+    globalTagBits.resize(n * 8);
+
+    for (size_t i = 0; i < n; i++) {
+        globalPrice[i] = globalGames[i].price;
+        globalReview[i] = globalGames[i].reviewScore;
+        globalMetacritic[i] = globalGames[i].metacriticScore;
+        globalDeveloper[i] = globalGames[i].developerOffset;
+        globalPublisher[i] = globalGames[i].publisherOffset;
+        std::copy(globalGames[i].tagBits, globalGames[i].tagBits + 8, &globalTagBits[i * 8]);
+    }
+
+    buildBitmaps(priceBitmaps, globalPrice);
+    buildBitmaps(reviewBitmaps, globalReview);
+    buildBitmaps(metacriticBitmaps, globalMetacritic);
+}
+
+// Jaccard's Tag Similarity
+inline float getJaccard(const CompactGame& a, const CompactGame& b) {
+    int intersect = 0, unionSize = 0;
+    for (int i = 0; i < 8; i++) {
+        intersect += __builtin_popcount(a.tagBits[i] & b.tagBits[i]);
+        unionSize += __builtin_popcount(a.tagBits[i] | b.tagBits[i]);
+    }
+    return unionSize == 0 ? 0 : (float)intersect / unionSize;
+}
+
+// MinHash
+inline float getMinHash(const CompactGame& a, const CompactGame& b) {
+    int matches = 0;
+    for (int i = 0; i < 150; i++) {
+        if (a.minHashSignature[i] == b.minHashSignature[i]) matches++;
+    }
+    return (float)matches / 150.0f;
+}
+
+// Weighted Cosine
+inline float getCosine(const CompactGame& a, const CompactGame& b) {
+    float dot = 0;
+    for (int i = 0; i < 128; i++) dot += a.cosineSignature[i] * b.cosineSignature[i];
+    return dot;
+}
+
+// index of a game reference into globalGames
+inline int gameIndex(const CompactGame& g) {
+    return (int)(&g - globalGames.data());
+}
+
+// position of a loaded game in the whole catalog, equal to its index unless this process is a shard
+inline uint32_t catalogIndex(int idx) {
+    for (const auto& range : globalCatalogRanges) {
+        if ((size_t)idx < range.localStart + range.count) return (uint32_t)(range.catalogStart + idx - range.localStart);
+    }
+    return (uint32_t)idx;
+}
+
+// Weighted Jaccard over normalized tag votes: sum(min) / sum(max), with
+// sum(max) = totalA + totalB - sum(min), so one merge over the sorted arrays is enough.
+// The first game is given by its votes so a shard can score a target it does not hold.
+inline float getWeightedJaccard(const TagWeight* pa, const TagWeight* endA, uint32_t totalA, int b) {
+    const TagWeight* pb = &globalVotes[0] + globalVoteOffsets[b];
+    const TagWeight* endB = &globalVotes[0] + globalVoteOffsets[b + 1];
+
+    uint32_t intersect = 0;
+    while (pa < endA && pb < endB) {
+        if (pa->tag == pb->tag) {
+            intersect += std::min(pa->weight, pb->weight);
+            pa++;
+            pb++;
+        } else if (pa->tag < pb->tag) {
+            pa++;
+        } else {
+            pb++;
+        }
+    }
+
+    uint32_t unionSum = totalA + globalVoteTotal[b] - intersect;
+    return unionSum == 0 ? 0 : (float)intersect / unionSum;
+}
+
+inline float getWeightedJaccard(int a, int b) {
+    if (globalVoteOffsets.empty()) return getJaccard(globalGames[a], globalGames[b]);
+    return getWeightedJaccard(&globalVotes[0] + globalVoteOffsets[a], &globalVotes[0] + globalVoteOffsets[a + 1],
+                              globalVoteTotal[a], b);
+}
+
+// Price / review / metacritic filter, evaluated before any similarity math
+struct ScanFilter {
+    float minPrice = -std::numeric_limits<float>::infinity();
+    float maxPrice = std::numeric_limits<float>::infinity();
+    float minReview = -std::numeric_limits<float>::infinity();
+    float maxReview = std::numeric_limits<float>::infinity();
+    float minMetacritic = -std::numeric_limits<float>::infinity();
+    float maxMetacritic = std::numeric_limits<float>::infinity();
+    bool active = false;
+
+    bool matches(size_t i) const {
+        return globalPrice[i] >= minPrice && globalPrice[i] <= maxPrice &&
+               globalReview[i] >= minReview && globalReview[i] <= maxReview &&
+               globalMetacritic[i] >= minMetacritic && globalMetacritic[i] <= maxMetacritic;
+    }
+};
+
+// narrows candidates to a superset of [minVal, maxVal] using the nearest precomputed cuts
+inline void applyBitmaps(std::vector<uint64_t>& candidates, const ColumnBitmaps& bitmaps, float minVal, float maxVal) {
+    const auto& cuts = bitmaps.cuts;
+
+    // value <= maxVal is contained in value <= (smallest cut >= maxVal)
+    auto hi = std::lower_bound(cuts.begin(), cuts.end(), maxVal);
+    if (hi != cuts.end()) {
+        const auto& bits = bitmaps.lessEqual[hi - cuts.begin()];
+        for (size_t w = 0; w < candidates.size(); w++) candidates[w] &= bits[w];
+    }
+
+    // value >= minVal is contained in value > (largest cut < minVal)
+    auto lo = std::lower_bound(cuts.begin(), cuts.end(), minVal);
+    if (lo != cuts.begin()) {
+        const auto& bits = bitmaps.lessEqual[(lo - cuts.begin()) - 1];
+        for (size_t w = 0; w < candidates.size(); w++) candidates[w] &= ~bits[w];
+    }
+}
+
+// Deadline of the request whose scan is running on this thread. Scans check it every SCAN_CHUNK
+// games and stop early once it has passed, leaving expired set so the caller can flag the
+// results as partial.
+struct ScanDeadline {
+    std::chrono::steady_clock::time_point at;
+    bool expired = false;
+};
+
+inline thread_local ScanDeadline* activeDeadline = nullptr;
+
+constexpr int SCAN_CHUNK = 4096;
+
+inline bool scanExpired() {
+    if (!activeDeadline) return false;
+    if (!activeDeadline->expired && std::chrono::steady_clock::now() > activeDeadline->at) activeDeadline->expired = true;
+    return activeDeadline->expired;
+}
+
+// Installs a deadline for the scans run in this scope
+class DeadlineScope {
+public:
+    explicit DeadlineScope(ScanDeadline& deadline) : previous(activeDeadline) { activeDeadline = &deadline; }
+    ~DeadlineScope() { activeDeadline = previous; }
+
+private:
+    ScanDeadline* previous;
+};
+
+// Scores every game that passes the filter, skipping the sorted indices in exclude (the seeds).
+// With an active filter the bitmaps are ANDed first so only surviving games are visited.
+template <typename ScoreFn>
+inline ScoredList scanCatalog(const ScanFilter& filter, const std::vector<int>& exclude, float threshold, ScoreFn score) {
+    StageTimer timer(Stage::SCAN);
+    ScoredList results;
+    int n = (int)globalGames.size();
+
+    // both scan paths visit indices in increasing order, so one cursor walks the exclusion list
+    size_t nextExcluded = 0;
+    uint64_t scored = 0;
+    auto visit = [&](int i) {
+        while (nextExcluded < exclude.size() && exclude[nextExcluded] < i) nextExcluded++;
+        if (nextExcluded < exclude.size() && exclude[nextExcluded] == i) return;
+        float s = score(globalGames[i]);
+        scored++;
+        if (s > threshold) results.push_back({s, i});
+    };
+
+    if (!filter.active) {
+        for (int start = 0; start < n && !scanExpired(); start += SCAN_CHUNK) {
+            int end = std::min(n, start + SCAN_CHUNK);
+            for (int i = start; i < end; i++) visit(i);
+        }
+        currentTrace.candidates += scored;
+        return results;
+    }
+
+    std::vector<uint64_t> candidates((n + 63) / 64, ~0ULL);
+    if (n % 64) candidates.back() = (1ULL << (n % 64)) - 1;
+
+    applyBitmaps(candidates, priceBitmaps, filter.minPrice, filter.maxPrice);
+    applyBitmaps(candidates, reviewBitmaps, filter.minReview, filter.maxReview);
+    applyBitmaps(candidates, metacriticBitmaps, filter.minMetacritic, filter.maxMetacritic);
+
+    for (size_t w = 0; w < candidates.size(); w++) {
+        if (w % (SCAN_CHUNK / 64) == 0 && scanExpired()) break;
+        uint64_t bits = candidates[w];
+        while (bits) {
+            int i = (int)(w * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+            if (filter.matches(i)) visit(i);
+        }
+    }
+    currentTrace.candidates += scored;
+    return results;
+}
+
+// best score first
+inline ScoredList rankByScore(ScoredList results) {
+    StageTimer timer(Stage::SORT);
+    std::sort(results.rbegin(), results.rend());
+    return results;
+}
+
+// Balanced blend used by /recommend/global
+inline float getGlobalScore(const CompactGame& a, const CompactGame& b) {
+    float s_jac = getJaccard(a, b);
+    float s_min = getMinHash(a, b);
+    float s_cos = getCosine(a, b);
+
+    return (s_cos * 0.5f) + (s_min * 0.3f) + (s_jac * 0.2f);
+}
+
+enum class SeedMode { Max, Mean, Centroid };
+
+// Everything a multi-seed scan needs, built once per request so the per-candidate cost of the
+// cosine and MinHash kernels does not depend on how many seeds were given
+struct SeedProfile {
+    std::vector<const CompactGame*> seeds;
+
+    // union of the seed tags, summed cosine vector and elementwise-min MinHash
+    // (the MinHash signature of the union of the seed tag sets)
+    CompactGame centroid = {};
+
+    // meanCosine[i] = average seed cosineSignature[i], dot(candidate, meanCosine) is the mean cosine
+    float meanCosine[128] = {};
+
+    // the seeds' signature values, seeds.size() per position and sorted within each position, so
+    // matches at a position are counted by binary search however large the hash values are
+    std::vector<uint32_t> minHashValues;
+};
+
+inline SeedProfile buildSeedProfile(const std::vector<int>& seedIndices) {
+    SeedProfile p;
+    for (int idx : seedIndices) p.seeds.push_back(&globalGames[idx]);
+
+    for (int i = 0; i < 150; i++) p.centroid.minHashSignature[i] = UINT32_MAX;
+
+    bool anySignature = false;
+    for (const CompactGame* s : p.seeds) {
+        for (int i = 0; i < 8; i++) p.centroid.tagBits[i] |= s->tagBits[i];
+        for (int i = 0; i < 128; i++) p.meanCosine[i] += s->cosineSignature[i];
+
+        // a tagless seed's signature is all zeros and would zero the union's, it adds no tags anyway
+        bool empty = std::all_of(s->minHashSignature, s->minHashSignature + 150, [](uint32_t v) { return v == 0; });
+        if (empty) continue;
+        anySignature = true;
+        for (int i = 0; i < 150; i++) {
+            p.centroid.minHashSignature[i] = std::min(p.centroid.minHashSignature[i], s->minHashSignature[i]);
+        }
+    }
+    if (!anySignature) std::fill(p.centroid.minHashSignature, p.centroid.minHashSignature + 150, 0u);
+
+    float sumSq = 0;
+    for (int i = 0; i < 128; i++) sumSq += p.meanCosine[i] * p.meanCosine[i];
+    float invRoot = sumSq > 0 ? 1.0f / std::sqrt(sumSq) : 0.0f;
+    for (int i = 0; i < 128; i++) {
+        p.centroid.cosineSignature[i] = p.meanCosine[i] * invRoot;
+        p.meanCosine[i] /= (float)p.seeds.size();
+    }
+
+    size_t n = p.seeds.size();
+    p.minHashValues.resize(150 * n);
+    for (int i = 0; i < 150; i++) {
+        uint32_t* values = &p.minHashValues[(size_t)i * n];
+        for (size_t k = 0; k < n; k++) values[k] = p.seeds[k]->minHashSignature[i];
+        std::sort(values, values + n);
+    }
+    return p;
+}
+
+// Mean of getGlobalScore over the seeds. Cosine and MinHash are linear in the seeds so they use the
+// precomputed mean vector and sorted signature values, only the 8 word Jaccard is evaluated per seed.
+inline float getSeedMeanScore(const SeedProfile& p, const CompactGame& g) {
+    float dot = 0;
+    for (int i = 0; i < 128; i++) dot += p.meanCosine[i] * g.cosineSignature[i];
+
+    int matches = 0;
+    size_t seedCount = p.seeds.size();
+    for (int i = 0; i < 150; i++) {
+        const uint32_t* values = &p.minHashValues[(size_t)i * seedCount];
+        auto [first, last] = std::equal_range(values, values + seedCount, g.minHashSignature[i]);
+        matches += (int)(last - first);
+    }
+
+    // a candidate sharing no tag bit with any seed has Jaccard 0 against all of them
+    float jac = 0;
+    bool overlaps = false;
+    for (int i = 0; i < 8; i++) overlaps |= (p.centroid.tagBits[i] & g.tagBits[i]) != 0;
+    if (overlaps) {
+        for (const CompactGame* s : p.seeds) jac += getJaccard(*s, g);
+    }
+
+    float n = (float)p.seeds.size();
+    return (dot * 0.5f) + ((float)matches / (150.0f * n) * 0.3f) + (jac / n * 0.2f);
+}
+
+inline float getSeedMaxScore(const SeedProfile& p, const CompactGame& g) {
+    float best = 0;
+    for (const CompactGame* s : p.seeds) best = std::max(best, getGlobalScore(*s, g));
+    return best;
+}
+
+// Weights for the multi-feature blend, defaults are the ones Legacy/main.cpp used
+struct FeatureWeights {
+    float tags = 0.5f;
+    float publishers = 0.1f;
+    float developers = 0.1f;
+    float reviewScore = 0.3f;
+};
+
+// Port of calculateOverallWeightedSimilarity over the columnar arrays. Each game has a single
+// interned developer / publisher, so their set Jaccard is 1 when the ids match and 0 otherwise.
+inline float getMultiFeature(int a, int b, const FeatureWeights& w) {
+    const uint32_t* bitsA = &globalTagBits[(size_t)a * 8];
+    const uint32_t* bitsB = &globalTagBits[(size_t)b * 8];
+    int intersect = 0, unionSize = 0;
+    for (int i = 0; i < 8; i++) {
+        intersect += __builtin_popcount(bitsA[i] & bitsB[i]);
+        unionSize += __builtin_popcount(bitsA[i] | bitsB[i]);
+    }
+    float tags = unionSize == 0 ? 0 : (float)intersect / unionSize;
+
+    float publishers = (globalPublisher[a] != 0 && globalPublisher[a] == globalPublisher[b]) ? 1.0f : 0.0f;
+    float developers = (globalDeveloper[a] != 0 && globalDeveloper[a] == globalDeveloper[b]) ? 1.0f : 0.0f;
+
+    float reviewA = globalReview[a], reviewB = globalReview[b];
+    float review = (reviewA < 0 || reviewB < 0) ? 0.0f : 1.0f - std::fabs(reviewA - reviewB);
+
+    float totalWeight = w.tags + w.publishers + w.developers + w.reviewScore;
+    if (totalWeight == 0.0f) return 0;
+
+    return (tags * w.tags + publishers * w.publishers + developers * w.developers + review * w.reviewScore) / totalWeight;
+}
+
+// Rule-based decision tree (port of Legacy/algorithms_B), best bucket first
+enum BucketLevel {
+    HIGH_RELEVANCE,
+    MEDIUM_RELEVANCE,
+    TAG_SIMILAR,
+    WEAK_SIMILAR,
+    LOW_RELEVANCE,
+    BUCKET_COUNT
+};
+
+// Candidates are every game sharing a tag with the target, ranked by tag Jaccard and normalized by
+// the best score. Like decisionTree/decisionTreeNext they are bucketed 1000 at a time, each chunk's
+// buckets sorted by review score and appended, so later pages continue where the legacy "next" did.
+inline ScoredList decisionTree(int targetIdx, const ScanFilter& filter) {
+    const CompactGame& target = globalGames[targetIdx];
+    ScoredList candidates = rankByScore(scanCatalog(filter, {targetIdx}, 0.0f, [&](const CompactGame& g) {
+        return getJaccard(target, g);
+    }));
+    if (candidates.empty()) return candidates;
+
+    float maxScore = candidates[0].first;
+    for (auto& c : candidates) c.first /= maxScore;
+
+    uint32_t dev = globalDeveloper[targetIdx];
+    uint32_t pub = globalPublisher[targetIdx];
+
+    ScoredList ordered;
+    ordered.reserve(candidates.size());
+    std::vector<std::pair<float, int>> buckets[BUCKET_COUNT];
+
+    const size_t chunk = 1000;
+    for (size_t start = 0; start < candidates.size(); start += chunk) {
+        for (auto& b : buckets) b.clear();
+
+        // one pass over the chunk with integer id compares, no string sets
+        for (size_t i = start; i < std::min(candidates.size(), start + chunk); i++) {
+            auto [score, idx] = candidates[i];
+            BucketLevel level = LOW_RELEVANCE;
+            if (dev != 0 && globalDeveloper[idx] == dev) level = HIGH_RELEVANCE;
+            else if (pub != 0 && globalPublisher[idx] == pub) level = MEDIUM_RELEVANCE;
+            else if (score > 0.74f) level = TAG_SIMILAR;
+            else if (score > 0.24f && globalReview[idx] > 0.85f) level = WEAK_SIMILAR;
+            buckets[level].push_back(candidates[i]);
+        }
+
+        for (auto& b : buckets) {
+            std::stable_sort(b.begin(), b.end(), [](const auto& a, const auto& c) {
+                return globalReview[a.second] > globalReview[c.second];
+            });
+            ordered.insert(ordered.end(), b.begin(), b.end());
+        }
+    }
+    return ordered;
+}
+
+// per worker thread response buffer, reused so steady state serialization does not reallocate
+inline std::string& responseBuffer() {
+    thread_local std::string buffer;
+    buffer.clear();
+    return buffer;
+}
+
+// Case-insensitive substring match over game names (query already lowercase), calls match(idx)
+// for the first maxResults hits in catalog order and returns how many there were
+template <typename MatchFn>
+inline int forEachNameMatch(const std::string& query, int maxResults, MatchFn match) {
+    StageTimer timer(Stage::SCAN);
+    int count = 0;
+
+    for (size_t i = 0; i < globalGames.size() && count < maxResults; i++) {
+        std::string nameLower = getString(globalGames[i].nameOffset);
+        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(), ::tolower);
+
+        if (nameLower.find(query) != std::string::npos) {
+            match((int)i);
+            count++;
+        }
+    }
+    return count;
+}
+
+// one /search suggestion: id, imageURL and name
+inline void renderSearchResult(JsonWriter& w, int idx) {
+    const auto& f = globalFragments[idx];
+    w.raw('{');
+    w.key("id");
+    w.raw(f.id(), f.idLength);
+    w.raw(',');
+    w.key("imageURL");
+    w.raw(f.imageUrl(), f.imageUrlLength);
+    w.raw(',');
+    w.key("name");
+    w.raw(f.name(), f.nameLength);
+    w.raw('}');
+}
+
+// Writes the first maxResults name matches as the /search JSON array and returns how many there were
+inline int searchByName(std::string& out, const std::string& query, int maxResults) {
+    JsonWriter w(out);
+    w.raw('[');
+    int count = forEachNameMatch(query, maxResults, [&](int idx) {
+        if (out.back() != '[') w.raw(',');
+        renderSearchResult(w, idx);
+    });
+    w.raw(']');
+    return count;
+}
+
+// Result fields, selectable with ?fields=id,name,...
+enum ResultField : uint32_t {
+    FIELD_ALGORITHM = 1 << 0,
+    FIELD_ID = 1 << 1,
+    FIELD_IMAGE_URL = 1 << 2,
+    FIELD_MIN_HASH = 1 << 3,
+    FIELD_NAME = 1 << 4,
+    FIELD_PRICE = 1 << 5,
+    FIELD_SCORE = 1 << 6,
+    FIELD_TAG_BITS = 1 << 7,
+};
+
+constexpr uint32_t ALL_FIELDS = 0xFF;
+// v=2 drops the 150 integer minHash and tagBits arrays that most clients never read
+constexpr uint32_t LEAN_FIELDS = FIELD_ALGORITHM | FIELD_ID | FIELD_IMAGE_URL | FIELD_NAME | FIELD_PRICE | FIELD_SCORE;
+
+// Appends one recommend result object for game idx, only the fields in mask. Keys are in the
+// sorted order the old nlohmann DOM dumped them in, so with every field selected the bytes are
+// unchanged. FIELD_ALGORITHM must be cleared when algorithm is null.
+inline void renderResult(JsonWriter& w, int idx, float score, const char* algorithm, uint32_t fields) {
+    const auto& g = globalGames[idx];
+    const auto& f = globalFragments[idx];
+    w.raw('{');
+
+    bool first = true;
+    auto field = [&](uint32_t bit, const char* key) {
+        if (!(fields & bit)) return false;
+        if (!first) w.raw(',');
+        first = false;
+        w.key(key);
+        return true;
+    };
+
+    if (field(FIELD_ALGORITHM, "algorithm")) w.string(algorithm);
+    if (field(FIELD_ID, "id")) w.raw(f.id(), f.idLength);
+    if (field(FIELD_IMAGE_URL, "imageURL")) w.raw(f.imageUrl(), f.imageUrlLength);
+    if (field(FIELD_MIN_HASH, "minHash")) {
+        w.raw('[');
+        for (int j = 0; j < 150; j++) {
+            if (j) w.raw(',');
+            w.integer(g.minHashSignature[j]);
+        }
+        w.raw(']');
+    }
+    if (field(FIELD_NAME, "name")) w.raw(f.name(), f.nameLength);
+    if (field(FIELD_PRICE, "price")) w.raw(f.price(), f.priceLength);
+    if (field(FIELD_SCORE, "score")) w.number(roundToTwo(score));
+    if (field(FIELD_TAG_BITS, "tagBits")) w.raw(f.tagBits(), f.tagBitsLength);
+    w.raw('}');
+}
+
+// Writes results[offset, offset + count) as the recommend JSON array
+inline void renderResults(std::string& out, const ScoredList& results, size_t offset, size_t count,
+                   const char* algorithm, uint32_t fields) {
+    if (!algorithm) fields &= ~FIELD_ALGORITHM;
+
+    JsonWriter w(out);
+    w.raw('[');
+    for (size_t i = offset; i < std::min(results.size(), offset + count); i++) {
+        if (i != offset) w.raw(',');
+        renderResult(w, results[i].second, results[i].first, algorithm, fields);
+    }
+    w.raw(']');
+}
+
+// Same schema as renderResult as one MessagePack map, written directly from the CompactGame fields.
+// Scores and prices go out as float32 (already rounded to two decimals).
+inline void renderResultMsgPack(MsgPackWriter& w, int idx, float score, const char* algorithm, uint32_t fields) {
+    const auto& g = globalGames[idx];
+
+    w.mapHeader(__builtin_popcount(fields));
+    if (fields & FIELD_ALGORITHM) {
+        w.string("algorithm");
+        w.string(algorithm);
+    }
+    if (fields & FIELD_ID) {
+        w.string("id");
+        w.integer(g.id);
+    }
+    if (fields & FIELD_IMAGE_URL) {
+        w.string("imageURL");
+        w.string(getString(g.imageUrlOffset));
+    }
+    if (fields & FIELD_MIN_HASH) {
+        w.string("minHash");
+        w.arrayHeader(150);
+        for (int j = 0; j < 150; j++) w.integer(g.minHashSignature[j]);
+    }
+    if (fields & FIELD_NAME) {
+        w.string("name");
+        w.string(getString(g.nameOffset));
+    }
+    if (fields & FIELD_PRICE) {
+        w.string("price");
+        w.float32(roundToTwo(g.price));
+    }
+    if (fields & FIELD_SCORE) {
+        w.string("score");
+        w.float32(roundToTwo(score));
+    }
+    if (fields & FIELD_TAG_BITS) {
+        w.string("tagBits");
+        w.arrayHeader(8);
+        for (int j = 0; j < 8; j++) w.integer(g.tagBits[j]);
+    }
+}
+
+// Same schema as renderResults as a MessagePack array
+inline void renderResultsMsgPack(std::string& out, const ScoredList& results, size_t offset, size_t count,
+                          const char* algorithm, uint32_t fields) {
+    if (!algorithm) fields &= ~FIELD_ALGORITHM;
+
+    MsgPackWriter w(out);
+    size_t end = std::min(results.size(), offset + count);
+    w.arrayHeader(end > offset ? (uint32_t)(end - offset) : 0);
+    for (size_t i = offset; i < end; i++) renderResultMsgPack(w, results[i].second, results[i].first, algorithm, fields);
+}
+
+#endif //STEAMSEARCH_CATALOG_H
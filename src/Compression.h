@@ -0,0 +1,77 @@
+#ifndef STEAMSEARCH_COMPRESSION_H
+#define STEAMSEARCH_COMPRESSION_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <zlib.h>
+
+// Bodies below this are sent as is, a gzip header plus a second round trip of CPU is not worth
+// it for a handful of search suggestions
+constexpr size_t COMPRESS_MIN_BYTES = 1400;
+
+// gzip (RFC 1952) of data, empty on failure
+inline std::string gzipCompress(const std::string& data, int level = Z_DEFAULT_COMPRESSION) {
+    z_stream zs = {};
+    // 15 window bits + 16 selects the gzip wrapper instead of raw zlib
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return "";
+
+    std::string out;
+    out.resize(deflateBound(&zs, data.size()));
+
+    zs.next_in = (Bytef*)data.data();
+    zs.avail_in = (uInt)data.size();
+    zs.next_out = (Bytef*)out.data();
+    zs.avail_out = (uInt)out.size();
+
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : "";
+}
+
+// q of wanted in a comma separated Accept style header, -1 when it is not listed. An entry naming
+// wanted overrides the wildcard (RFC 9110 12.5.3), so "gzip;q=0, *" refuses gzip. wildcard may be null.
+inline double headerQuality(const std::string& header, const std::string& wanted, const char* wildcard) {
+    double exact = -1, wild = -1;
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = header.find(',', pos);
+        if (end == std::string::npos) end = header.size();
+        std::string item = header.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t semi = item.find(';');
+        std::string token = item.substr(0, semi);
+        token.erase(0, token.find_first_not_of(" \t"));
+        token.erase(token.find_last_not_of(" \t") + 1);
+        bool isExact = token == wanted;
+        if (!isExact && (!wildcard || token != wildcard)) continue;
+
+        double q = 1.0;
+        if (semi != std::string::npos) {
+            std::string params = item.substr(semi + 1);
+            size_t qAt = params.find("q=");
+            if (qAt != std::string::npos) q = std::strtod(params.c_str() + qAt + 2, nullptr);
+        }
+        double& slot = isExact ? exact : wild;
+        slot = std::max(slot, q);
+    }
+    return exact >= 0 ? exact : wild;
+}
+
+// true when the header lists wanted, or only the wildcard, with a q above 0
+inline bool headerAccepts(const std::string& header, const std::string& wanted, const char* wildcard) {
+    return headerQuality(header, wanted, wildcard) > 0;
+}
+
+// true when Accept-Encoding lists coding (or *) without q=0
+inline bool acceptsEncoding(const std::string& acceptEncoding, const std::string& wanted) {
+    return headerAccepts(acceptEncoding, wanted, "*");
+}
+
+inline bool acceptsGzip(const std::string& acceptEncoding) {
+    return acceptsEncoding(acceptEncoding, "gzip");
+}
+
+#endif //STEAMSEARCH_COMPRESSION_H
@@ -0,0 +1,34 @@
+#ifndef STEAMSEARCH_HASH_H
+#define STEAMSEARCH_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 64-bit FNV-1a, the one hash behind cursors, ETags and the dataset version
+constexpr uint64_t FNV_OFFSET_BASIS = 1469598103934665603ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+// byte by byte FNV-1a, stable across processes so a cursor or ETag stays valid on any server instance
+inline uint64_t hashKey(const std::string& key, uint64_t h = FNV_OFFSET_BASIS) {
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+// FNV style mix over 8 byte words, fast enough to hash the whole dataset at startup
+inline uint64_t hashWords(const void* data, size_t bytes, uint64_t h = FNV_OFFSET_BASIS) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * FNV_PRIME;
+    }
+    for (; i < bytes; i++) h = (h ^ p[i]) * FNV_PRIME;
+    return h;
+}
+
+#endif //STEAMSEARCH_HASH_H
@@ -0,0 +1,271 @@
+#ifndef STEAMSEARCH_HTTPCLIENT_H
+#define STEAMSEARCH_HTTPCLIENT_H
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct HttpResponse {
+    int status = 0;
+    std::string headers;  // raw header block, lowercase names are not guaranteed
+    std::string body;
+
+    // value of the first header called name (any case), empty when there is none
+    std::string header(const std::string& name) const {
+        size_t start = 0;
+        while (start < headers.size()) {
+            size_t end = headers.find("\r\n", start);
+            if (end == std::string::npos) end = headers.size();
+            size_t colon = headers.find(':', start);
+            if (colon < end && colon - start == name.size() &&
+                std::equal(name.begin(), name.end(), headers.begin() + start, [](char a, char b) {
+                    return std::tolower((unsigned char)a) == std::tolower((unsigned char)b);
+                })) {
+                size_t valueStart = headers.find_first_not_of(' ', colon + 1);
+                return valueStart < end ? headers.substr(valueStart, end - valueStart) : "";
+            }
+            start = end + 2;
+        }
+        return "";
+    }
+};
+
+// Blocking HTTP/1.1 client over one keep-alive connection (POSIX sockets). Enough for talking to
+// steam_server: Content-Length or chunked bodies, no TLS, no redirects. A request is only sent
+// again when it went out on a kept-alive connection the server had already closed, before any byte
+// of an answer came back. Timeouts and broken answers fail, so callers see every real error.
+class HttpConnection {
+public:
+    HttpConnection(std::string host, int port, int timeoutMs = 10000)
+        : host(std::move(host)), port(port), timeoutMs(timeoutMs) {}
+    ~HttpConnection() { close(); }
+
+    HttpConnection(const HttpConnection&) = delete;
+    HttpConnection& operator=(const HttpConnection&) = delete;
+
+    // extraHeaders are complete "Name: value\r\n" lines
+    bool get(const std::string& path, HttpResponse& response, const std::string& extraHeaders = "") {
+        return send("GET", path, "", extraHeaders) && receive(response);
+    }
+
+    bool post(const std::string& path, const std::string& body, HttpResponse& response,
+              const std::string& extraHeaders = "") {
+        return send("POST", path, body, extraHeaders) && receive(response);
+    }
+
+    // Writes a request without waiting for the answer, so requests to several servers run at the
+    // same time. Every successful send is followed by exactly one receive.
+    bool send(const char* method, const std::string& path, const std::string& body, const std::string& extraHeaders) {
+        pending = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + host + "\r\n" + extraHeaders;
+        if (!body.empty() || std::strcmp(method, "GET") != 0) pending += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        pending += "\r\n";
+        pending += body;
+
+        reused = fd >= 0;
+        if (fd < 0 && !connect()) return false;
+        if (sendAll(pending)) return true;
+        close();
+        // a write can only fail early on a connection the server closed while it sat idle
+        if (!reused) return false;
+        reused = false;
+        if (connect() && sendAll(pending)) return true;
+        close();
+        return false;
+    }
+
+    // deadline bounds the whole answer on top of the socket timeout
+    bool receive(HttpResponse& response,
+                 std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        if (fd < 0) return false;
+        received = false;
+        timedOut = false;
+        this->deadline = deadline;
+        if (readResponse(response)) return true;
+
+        bool closedWhileIdle = reused && !received && !timedOut;
+        close();
+        if (!closedWhileIdle) return false;
+        reused = false;
+        if (connect() && sendAll(pending) && readResponse(response)) return true;
+        close();
+        return false;
+    }
+
+    // the socket to poll for the answer to a sent request, -1 when there is none
+    int handle() const { return fd; }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        buffer.clear();
+    }
+
+private:
+    bool connect() {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) return false;
+
+        for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+            fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+            ::close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(result);
+        if (fd < 0) return false;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        return true;
+    }
+
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                return false;
+            }
+            sent += (size_t)n;
+        }
+        return true;
+    }
+
+    // appends whatever the socket has, false on EOF, error or timeout
+    bool fill() {
+        char chunk[16384];
+        if (deadline != std::chrono::steady_clock::time_point::max()) {
+            pollfd pfd{fd, POLLIN, 0};
+            int ready;
+            do {
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                ready = left.count() > 0 ? ::poll(&pfd, 1, (int)std::min<long long>(left.count(), INT32_MAX)) : 0;
+            } while (ready < 0 && errno == EINTR);
+            if (ready == 0) timedOut = true;
+            if (ready <= 0) return false;
+        }
+        for (;;) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                buffer.append(chunk, (size_t)n);
+                received = true;
+                return true;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) timedOut = true;
+            return false;
+        }
+    }
+
+    // takes one line ending in \r\n from the buffer, reading more as needed
+    bool readLine(std::string& line) {
+        size_t end;
+        while ((end = buffer.find("\r\n")) == std::string::npos) {
+            if (!fill()) return false;
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return true;
+    }
+
+    bool readBytes(size_t n, std::string& out) {
+        while (buffer.size() < n) {
+            if (!fill()) return false;
+        }
+        out.append(buffer, 0, n);
+        buffer.erase(0, n);
+        return true;
+    }
+
+    bool readResponse(HttpResponse& response) {
+        response = HttpResponse();
+        std::string line;
+        if (!readLine(line) || line.compare(0, 5, "HTTP/") != 0) return false;
+        size_t space = line.find(' ');
+        if (space == std::string::npos) return false;
+        response.status = std::atoi(line.c_str() + space + 1);
+
+        long long contentLength = -1;
+        bool chunked = false;
+        bool closeAfter = false;
+        while (readLine(line) && !line.empty()) {
+            response.headers += line;
+            response.headers += "\r\n";
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            for (auto& c : name) c = (char)std::tolower((unsigned char)c);
+            size_t valueStart = line.find_first_not_of(' ', colon + 1);
+            std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+            if (name == "content-length") contentLength = std::atoll(value.c_str());
+            else if (name == "transfer-encoding") chunked = value.find("chunked") != std::string::npos;
+            else if (name == "connection") closeAfter = value.find("close") != std::string::npos;
+        }
+        if (!line.empty()) return false;
+
+        bool ok = true;
+        if (response.status == 204 || response.status == 304) {
+            // no body
+        } else if (chunked) {
+            for (;;) {
+                if (!readLine(line)) return false;
+                size_t size = std::strtoul(line.c_str(), nullptr, 16);
+                if (size == 0) {
+                    while (readLine(line) && !line.empty()) {}
+                    break;
+                }
+                if (!readBytes(size, response.body) || !readLine(line)) return false;
+            }
+        } else if (contentLength >= 0) {
+            ok = readBytes((size_t)contentLength, response.body);
+        } else {
+            while (fill()) {}
+            response.body = std::move(buffer);
+            buffer.clear();
+            closeAfter = true;
+        }
+        if (closeAfter) close();
+        return ok;
+    }
+
+    std::string host;
+    int port;
+    int timeoutMs;
+    int fd = -1;
+    std::string buffer;
+    std::string pending; // last request, resent once if the connection turns out to be dead
+    bool reused = false;   // pending went out on a connection kept alive from an earlier request
+    bool received = false; // some byte of the current answer has arrived
+    bool timedOut = false;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+#endif //STEAMSEARCH_HTTPCLIENT_H
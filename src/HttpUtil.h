@@ -0,0 +1,84 @@
+#ifndef STEAMSEARCH_HTTPUTIL_H
+#define STEAMSEARCH_HTTPUTIL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <crow.h>
+#include "Compression.h"
+#include "Hash.h"
+
+// Request handling shared by steam_server and steam_coordinator
+
+inline int envInt(const char* name, int fallback) {
+    const char* raw = std::getenv(name);
+    return raw ? std::atoi(raw) : fallback;
+}
+
+// q of a media type in Accept: its own entry, else type/*, else */*, -1 when none matches
+inline double mediaQuality(const std::string& accept, const std::string& type) {
+    double q = headerQuality(accept, type, nullptr);
+    if (q < 0) q = headerQuality(accept, type.substr(0, type.find('/')) + "/*", nullptr);
+    if (q < 0) q = headerQuality(accept, "*/*", nullptr);
+    return q;
+}
+
+// Accept negotiation for internal callers. MessagePack has to be named and preferred over JSON,
+// which it beats on a tie only when JSON is matched by a wildcard. Anything else gets JSON.
+inline bool wantsMsgPack(const crow::request& req) {
+    const std::string& accept = req.get_header_value("Accept");
+    double msgpack = -1;
+    for (const char* type : {"application/msgpack", "application/x-msgpack", "application/vnd.msgpack"}) {
+        msgpack = std::max(msgpack, headerQuality(accept, type, nullptr));
+    }
+    if (msgpack <= 0) return false;
+
+    double json = headerQuality(accept, "application/json", nullptr);
+    if (json >= 0) return msgpack > json;
+    return msgpack >= mediaQuality(accept, "application/json");
+}
+
+// Responses are a pure function of (dataset, request), so the validator is the dataset version plus
+// a hash of the canonical request key including the negotiated representation
+inline std::string makeETag(uint64_t datasetVersion, const std::string& requestKey) {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "\"%016llx-%016llx\"",
+                  (unsigned long long)datasetVersion, (unsigned long long)hashKey(requestKey));
+    return buf;
+}
+
+// If-None-Match is a comma separated list of (possibly weak) tags, or *
+inline bool etagMatches(const crow::request& req, const std::string& etag) {
+    const std::string& header = req.get_header_value("If-None-Match");
+    if (header.empty()) return false;
+
+    std::stringstream ss(header);
+    std::string tag;
+    while (std::getline(ss, tag, ',')) {
+        tag.erase(0, tag.find_first_not_of(" \t"));
+        tag.erase(tag.find_last_not_of(" \t") + 1);
+        if (tag.rfind("W/", 0) == 0) tag.erase(0, 2);
+        if (tag == etag || tag == "*") return true;
+    }
+    return false;
+}
+
+inline const char* CACHE_CONTROL = "public, max-age=3600";
+
+inline void addValidators(crow::response& response, const std::string& etag) {
+    response.add_header("ETag", etag);
+    response.add_header("Cache-Control", CACHE_CONTROL);
+}
+
+inline crow::response notModified(const std::string& etag, const char* vary) {
+    crow::response response(304);
+    response.add_header("Access-Control-Allow-Origin", "*");
+    response.add_header("Vary", vary);
+    addValidators(response, etag);
+    return response;
+}
+
+#endif //STEAMSEARCH_HTTPUTIL_H
@@ -0,0 +1,78 @@
+#ifndef STEAMSEARCH_JSONWRITER_H
+#define STEAMSEARCH_JSONWRITER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Appends JSON straight into a caller owned buffer, formatting numbers exactly like
+// nlohmann::json::dump() so responses stay byte-compatible with the DOM based ones.
+// Callers are responsible for structure (commas, braces) and for writing object keys in
+// sorted order, which is the order nlohmann's std::map objects dump in.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out(out) {}
+
+    void raw(char c) { out.push_back(c); }
+    void raw(const char* s, size_t n) { out.append(s, n); }
+    void raw(const char* s) { out.append(s); }
+
+    // "key": with the key written verbatim, keys are plain ASCII literals
+    void key(const char* k) {
+        out.push_back('"');
+        out.append(k);
+        out.append("\":", 2);
+    }
+
+    void integer(uint64_t v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, res.ptr - buf);
+    }
+
+    // floats are widened to double like the DOM does, then printed with the same Grisu2
+    // routine dump() uses (std::to_chars picks a different last digit in ~10% of cases)
+    void number(double v) {
+        if (!std::isfinite(v)) {
+            out.append("null", 4);
+            return;
+        }
+        char buf[64];
+        char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, end - buf);
+    }
+
+    // escapes like dump() for valid UTF-8, pool strings are pre-escaped at load time instead
+    void string(const char* s) {
+        out.push_back('"');
+        for (; *s; s++) {
+            unsigned char c = (unsigned char)*s;
+            switch (c) {
+                case '"': out.append("\\\"", 2); break;
+                case '\\': out.append("\\\\", 2); break;
+                case '\b': out.append("\\b", 2); break;
+                case '\f': out.append("\\f", 2); break;
+                case '\n': out.append("\\n", 2); break;
+                case '\r': out.append("\\r", 2); break;
+                case '\t': out.append("\\t", 2); break;
+                default:
+                    if (c <= 0x1F) {
+                        char buf[7];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out.append(buf, 6);
+                    } else {
+                        out.push_back((char)c);
+                    }
+            }
+        }
+        out.push_back('"');
+    }
+
+private:
+    std::string& out;
+};
+
+#endif //STEAMSEARCH_JSONWRITER_H
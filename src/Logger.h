@@ -0,0 +1,204 @@
+#ifndef STEAMSEARCH_LOGGER_H
+#define STEAMSEARCH_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JsonWriter.h"
+
+enum class LogLevel : uint8_t { DEBUG, INFO, WARNING, ERROR };
+
+inline const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "debug";
+        case LogLevel::INFO: return "info";
+        case LogLevel::WARNING: return "warning";
+        default: return "error";
+    }
+}
+
+inline LogLevel parseLogLevel(const char* s, LogLevel fallback) {
+    if (!s) return fallback;
+    std::string name = s;
+    for (auto& c : name) c = (char)std::tolower((unsigned char)c);
+    if (name == "debug") return LogLevel::DEBUG;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "warning") return LogLevel::WARNING;
+    if (name == "error") return LogLevel::ERROR;
+    return fallback;
+}
+
+// Structured logger that keeps I/O off the request path. Each thread appends fixed size records
+// to its own single-producer ring, a background thread drains every ring and writes one JSON
+// object per line. A full ring drops the record (and counts it) rather than blocking the caller.
+class Logger {
+public:
+    static constexpr size_t RING_SIZE = 1024;
+    static constexpr size_t MESSAGE_BYTES = 232;
+
+    void configure(LogLevel level, uint32_t sampleEvery, FILE* sink) {
+        minLevel = level;
+        sampleRate = std::max(1u, sampleEvery);
+        out = sink;
+    }
+
+    bool enabled(LogLevel level) const { return level >= minLevel; }
+
+    // true for one in every sampleRate calls on this thread, for events too frequent to log all
+    bool sampled() {
+        thread_local uint32_t counter = 0;
+        return counter++ % sampleRate == 0;
+    }
+
+    // event must be a string literal, message is truncated to MESSAGE_BYTES on a UTF-8 character
+    // boundary so the JSON line stays valid
+    void log(LogLevel level, const char* event, const char* message, size_t length) {
+        if (!enabled(level)) return;
+        Ring& ring = threadRing();
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Record& record = ring.records[head % RING_SIZE];
+        record.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        record.level = level;
+        record.event = event;
+        size_t cut = std::min(length, MESSAGE_BYTES);
+        while (cut < length && cut > 0 && ((unsigned char)message[cut] & 0xC0) == 0x80) cut--;
+        record.length = (uint16_t)cut;
+        std::memcpy(record.message, message, record.length);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void log(LogLevel level, const char* event, const std::string& message) {
+        log(level, event, message.data(), message.size());
+    }
+
+    // Background threads do not survive fork(), so start() runs once the process is final
+    void start() {
+        if (drainer.joinable()) return;
+        running = true;
+        drainer = std::thread([this] {
+            std::string buffer;
+            while (running.load(std::memory_order_relaxed)) {
+                if (drain(buffer) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            drain(buffer);
+        });
+    }
+
+    void stop() {
+        if (!drainer.joinable()) return;
+        running = false;
+        drainer.join();
+    }
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    ~Logger() { stop(); }
+
+private:
+    struct Record {
+        int64_t timeUs;
+        const char* event;
+        LogLevel level;
+        uint16_t length;
+        char message[MESSAGE_BYTES];
+    };
+
+    struct Ring {
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        uint32_t thread;
+        Record records[RING_SIZE];
+    };
+
+    // rings are registered once per thread and live as long as the logger
+    Ring& threadRing() {
+        thread_local Ring* ring = nullptr;
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<Ring>());
+            ring = rings.back().get();
+            ring->thread = (uint32_t)rings.size() - 1;
+        }
+        return *ring;
+    }
+
+    size_t drain(std::string& buffer) {
+        std::vector<Ring*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (auto& ring : rings) snapshot.push_back(ring.get());
+        }
+
+        size_t written = 0;
+        buffer.clear();
+        JsonWriter json(buffer);
+        for (Ring* ring : snapshot) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail < head; tail++, written++) {
+                const Record& record = ring->records[tail % RING_SIZE];
+                std::string message(record.message, record.length);
+                json.raw('{');
+                json.key("ts_us");
+                json.integer((uint64_t)record.timeUs);
+                json.raw(',');
+                json.key("level");
+                json.string(logLevelName(record.level));
+                json.raw(',');
+                json.key("thread");
+                json.integer(ring->thread);
+                json.raw(',');
+                json.key("event");
+                json.string(record.event);
+                json.raw(',');
+                json.key("msg");
+                json.string(message.c_str());
+                json.raw("}\n");
+            }
+            ring->tail.store(tail, std::memory_order_release);
+        }
+
+        uint64_t total = dropped.load(std::memory_order_relaxed);
+        if (total > reportedDrops) {
+            std::string note = std::to_string(total - reportedDrops) + " records dropped, log rings full";
+            json.raw("{\"event\":\"logger\",\"level\":\"warning\",\"msg\":");
+            json.string(note.c_str());
+            json.raw("}\n");
+            reportedDrops = total;
+        }
+
+        if (!buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), out);
+            std::fflush(out);
+        }
+        return written;
+    }
+
+    LogLevel minLevel = LogLevel::INFO;
+    uint32_t sampleRate = 1;
+    FILE* out = stdout;
+
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::atomic<uint64_t> dropped{0};
+    uint64_t reportedDrops = 0;
+    std::atomic<bool> running{false};
+    std::thread drainer;
+};
+
+#endif //STEAMSEARCH_LOGGER_H
@@ -0,0 +1,242 @@
+#ifndef STEAMSEARCH_METRICS_H
+#define STEAMSEARCH_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Process wide counters that are not tied to a route
+enum class Counter : uint8_t {
+    PAGE_CACHE_HIT,
+    PAGE_CACHE_MISS,
+    RESULT_STORE_HIT,
+    RESULT_STORE_MISS,
+    PARTIAL_RESULTS,
+    COUNT
+};
+
+// Request stages timed for Server-Timing and the stage histograms
+enum class Stage : uint8_t {
+    LOOKUP,
+    SCAN,
+    SORT,
+    SERIALIZE,
+    COMPRESS,
+    COUNT
+};
+
+inline const char* stageName(Stage stage) {
+    static const char* names[] = {"lookup", "scan", "sort", "serialize", "compress"};
+    return names[(int)stage];
+}
+
+// Request metrics in the Prometheus text format. A series is a (route, algorithm) pair registered
+// before the workers start. Every thread bumps its own shard with plain relaxed loads and stores,
+// so recording never contends, and a scrape sums the shards. Every series is labelled with the
+// worker process, so scrapes of different WORKERS processes stay separate series.
+class Metrics {
+public:
+    static constexpr int MAX_SERIES = 32;
+    static constexpr int CODES = 7;
+    static constexpr int BUCKETS = 14;
+    static constexpr int STAGES = (int)Stage::COUNT;
+
+    // registration is not thread safe, it happens in main before the server runs
+    int series(const std::string& route, const std::string& algorithm) {
+        for (size_t i = 0; i < labels.size(); i++) {
+            if (labels[i].route == route && labels[i].algorithm == algorithm) return (int)i;
+        }
+        if (labels.size() >= MAX_SERIES) return 0;
+        labels.push_back({route, algorithm});
+        return (int)labels.size() - 1;
+    }
+
+    void setWorker(int index) { worker = "worker=\"" + std::to_string(index) + "\""; }
+    const std::string& workerLabel() const { return worker; }
+
+    const std::string& route(int series) const { return labels[series].route; }
+    const std::string& algorithm(int series) const { return labels[series].algorithm; }
+
+    void observeRequest(int series, int code, double seconds, uint64_t candidates, uint64_t results) {
+        Shard& shard = threadShard();
+        bump(shard.requests[series][codeIndex(code)]);
+        bump(shard.latency[series][bucketIndex(seconds)]);
+        bump(shard.latencySumUs[series], (uint64_t)(seconds * 1e6));
+        bump(shard.candidates[series], candidates);
+        bump(shard.results[series], results);
+    }
+
+    void observeStage(int series, Stage stage, double seconds) {
+        Shard& shard = threadShard();
+        bump(shard.stageLatency[series][(int)stage][bucketIndex(seconds)]);
+        bump(shard.stageSumUs[series][(int)stage], (uint64_t)(seconds * 1e6));
+    }
+
+    void count(Counter counter, uint64_t n = 1) { bump(threadShard().counters[(int)counter], n); }
+
+    // Appends every series and counter, summed over the thread shards
+    void render(std::string& out) {
+        std::vector<Shard*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            for (auto& shard : shards) snapshot.push_back(shard.get());
+        }
+        auto sum = [&](auto field) {
+            uint64_t total = 0;
+            for (Shard* shard : snapshot) total += field(*shard).load(std::memory_order_relaxed);
+            return total;
+        };
+
+        out += "# HELP steam_requests_total Requests handled, by route, algorithm and status code.\n";
+        out += "# TYPE steam_requests_total counter\n";
+        for (int s = 0; s < (int)labels.size(); s++) {
+            for (int c = 0; c < CODES; c++) {
+                uint64_t n = sum([&](Shard& shard) -> auto& { return shard.requests[s][c]; });
+                if (n == 0) continue;
+                line(out, "steam_requests_total", s, std::string("code=\"") + CODE_LABELS[c] + "\"", n);
+            }
+        }
+
+        out += "# HELP steam_request_duration_seconds Time spent in the handler.\n";
+        out += "# TYPE steam_request_duration_seconds histogram\n";
+        for (int s = 0; s < (int)labels.size(); s++) {
+            uint64_t cumulative = 0;
+            for (int b = 0; b < BUCKETS; b++) {
+                cumulative += sum([&](Shard& shard) -> auto& { return shard.latency[s][b]; });
+                line(out, "steam_request_duration_seconds_bucket", s, std::string("le=\"") + BUCKET_LABELS[b] + "\"", cumulative);
+            }
+            char seconds[32];
+            std::snprintf(seconds, sizeof(seconds), "%.6f",
+                          sum([&](Shard& shard) -> auto& { return shard.latencySumUs[s]; }) / 1e6);
+            out += "steam_request_duration_seconds_sum" + labelSet(s, "") + " " + seconds + "\n";
+            line(out, "steam_request_duration_seconds_count", s, "", cumulative);
+        }
+
+        out += "# HELP steam_stage_duration_seconds Time spent per request stage.\n";
+        out += "# TYPE steam_stage_duration_seconds histogram\n";
+        for (int s = 0; s < (int)labels.size(); s++) {
+            for (int st = 0; st < STAGES; st++) {
+                std::string stage = std::string("stage=\"") + stageName((Stage)st) + "\"";
+                uint64_t cumulative = 0;
+                std::string buckets;
+                for (int b = 0; b < BUCKETS; b++) {
+                    cumulative += sum([&](Shard& shard) -> auto& { return shard.stageLatency[s][st][b]; });
+                    line(buckets, "steam_stage_duration_seconds_bucket", s, stage + ",le=\"" + BUCKET_LABELS[b] + "\"", cumulative);
+                }
+                // stages a route never runs (no scan behind /search) are left out
+                if (cumulative == 0) continue;
+                out += buckets;
+                char seconds[32];
+                std::snprintf(seconds, sizeof(seconds), "%.6f",
+                              sum([&](Shard& shard) -> auto& { return shard.stageSumUs[s][st]; }) / 1e6);
+                out += "steam_stage_duration_seconds_sum" + labelSet(s, stage) + " " + seconds + "\n";
+                line(out, "steam_stage_duration_seconds_count", s, stage, cumulative);
+            }
+        }
+
+        out += "# HELP steam_candidates_scored_total Games scored by catalog scans.\n";
+        out += "# TYPE steam_candidates_scored_total counter\n";
+        for (int s = 0; s < (int)labels.size(); s++) {
+            line(out, "steam_candidates_scored_total", s, "", sum([&](Shard& shard) -> auto& { return shard.candidates[s]; }));
+        }
+
+        out += "# HELP steam_results_returned_total Results written into response bodies.\n";
+        out += "# TYPE steam_results_returned_total counter\n";
+        for (int s = 0; s < (int)labels.size(); s++) {
+            line(out, "steam_results_returned_total", s, "", sum([&](Shard& shard) -> auto& { return shard.results[s]; }));
+        }
+
+        auto counter = [&](Counter c) { return sum([&](Shard& shard) -> auto& { return shard.counters[(int)c]; }); };
+        out += "# HELP steam_cache_lookups_total Page cache and result store lookups.\n";
+        out += "# TYPE steam_cache_lookups_total counter\n";
+        out += "steam_cache_lookups_total{cache=\"page\",outcome=\"hit\"," + worker + "} " + std::to_string(counter(Counter::PAGE_CACHE_HIT)) + "\n";
+        out += "steam_cache_lookups_total{cache=\"page\",outcome=\"miss\"," + worker + "} " + std::to_string(counter(Counter::PAGE_CACHE_MISS)) + "\n";
+        out += "steam_cache_lookups_total{cache=\"result\",outcome=\"hit\"," + worker + "} " + std::to_string(counter(Counter::RESULT_STORE_HIT)) + "\n";
+        out += "steam_cache_lookups_total{cache=\"result\",outcome=\"miss\"," + worker + "} " + std::to_string(counter(Counter::RESULT_STORE_MISS)) + "\n";
+        out += "# HELP steam_partial_results_total Scans cut short by their deadline.\n";
+        out += "# TYPE steam_partial_results_total counter\n";
+        out += "steam_partial_results_total{" + worker + "} " + std::to_string(counter(Counter::PARTIAL_RESULTS)) + "\n";
+    }
+
+private:
+    static constexpr int CODE_VALUES[CODES - 1] = {200, 304, 400, 404, 500, 503};
+    static constexpr const char* CODE_LABELS[CODES] = {"200", "304", "400", "404", "500", "503", "other"};
+
+    // latency bucket bounds in seconds, the last bucket is +Inf
+    static constexpr double BUCKET_BOUNDS[BUCKETS - 1] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+                                                          0.025, 0.05, 0.1, 0.25, 0.5, 1.0};
+    static constexpr const char* BUCKET_LABELS[BUCKETS] = {"0.0001", "0.00025", "0.0005", "0.001", "0.0025",
+                                                           "0.005", "0.01", "0.025", "0.05", "0.1", "0.25",
+                                                           "0.5", "1", "+Inf"};
+
+    struct Labels {
+        std::string route;
+        std::string algorithm;
+    };
+
+    struct Shard {
+        std::atomic<uint64_t> requests[MAX_SERIES][CODES] = {};
+        std::atomic<uint64_t> latency[MAX_SERIES][BUCKETS] = {};
+        std::atomic<uint64_t> latencySumUs[MAX_SERIES] = {};
+        std::atomic<uint64_t> stageLatency[MAX_SERIES][STAGES][BUCKETS] = {};
+        std::atomic<uint64_t> stageSumUs[MAX_SERIES][STAGES] = {};
+        std::atomic<uint64_t> candidates[MAX_SERIES] = {};
+        std::atomic<uint64_t> results[MAX_SERIES] = {};
+        std::atomic<uint64_t> counters[(int)Counter::COUNT] = {};
+    };
+
+    // only the owning thread writes a shard, so no read-modify-write is needed
+    static void bump(std::atomic<uint64_t>& value, uint64_t n = 1) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static int codeIndex(int code) {
+        for (int i = 0; i < CODES - 1; i++) {
+            if (CODE_VALUES[i] == code) return i;
+        }
+        return CODES - 1;
+    }
+
+    static int bucketIndex(double seconds) {
+        for (int i = 0; i < BUCKETS - 1; i++) {
+            if (seconds <= BUCKET_BOUNDS[i]) return i;
+        }
+        return BUCKETS - 1;
+    }
+
+    std::string labelSet(int s, const std::string& extra) const {
+        std::string set = "{route=\"" + labels[s].route + "\"";
+        if (!labels[s].algorithm.empty()) set += ",algorithm=\"" + labels[s].algorithm + "\"";
+        if (!extra.empty()) set += "," + extra;
+        return set + "," + worker + "}";
+    }
+
+    void line(std::string& out, const char* name, int s, const std::string& extra, uint64_t value) const {
+        out += name;
+        out += labelSet(s, extra);
+        out += ' ';
+        out += std::to_string(value);
+        out += '\n';
+    }
+
+    Shard& threadShard() {
+        thread_local Shard* shard = nullptr;
+        if (!shard) {
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            shards.push_back(std::make_unique<Shard>());
+            shard = shards.back().get();
+        }
+        return *shard;
+    }
+
+    std::vector<Labels> labels;
+    std::string worker = "worker=\"0\"";
+    std::mutex shardsMutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+#endif //STEAMSEARCH_METRICS_H
@@ -0,0 +1,97 @@
+#ifndef STEAMSEARCH_MSGPACKWRITER_H
+#define STEAMSEARCH_MSGPACKWRITER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Appends MessagePack (https://msgpack.org/) into a caller owned buffer. Only the types the
+// recommend schema needs: maps, arrays, str, unsigned ints and float32. Multi-byte values are
+// big-endian as the format requires.
+class MsgPackWriter {
+public:
+    explicit MsgPackWriter(std::string& out) : out(out) {}
+
+    void arrayHeader(uint32_t n) {
+        if (n <= 15) {
+            byte(0x90 | n);
+        } else if (n <= 0xFFFF) {
+            byte(0xdc);
+            be16(n);
+        } else {
+            byte(0xdd);
+            be32(n);
+        }
+    }
+
+    void mapHeader(uint32_t n) {
+        if (n <= 15) {
+            byte(0x80 | n);
+        } else if (n <= 0xFFFF) {
+            byte(0xde);
+            be16(n);
+        } else {
+            byte(0xdf);
+            be32(n);
+        }
+    }
+
+    void string(const char* s, size_t n) {
+        if (n <= 31) {
+            byte(0xa0 | n);
+        } else if (n <= 0xFF) {
+            byte(0xd9);
+            byte(n);
+        } else if (n <= 0xFFFF) {
+            byte(0xda);
+            be16(n);
+        } else {
+            byte(0xdb);
+            be32(n);
+        }
+        out.append(s, n);
+    }
+
+    void string(const char* s) { string(s, std::strlen(s)); }
+
+    void integer(uint32_t v) {
+        if (v <= 0x7F) {
+            byte(v);
+        } else if (v <= 0xFF) {
+            byte(0xcc);
+            byte(v);
+        } else if (v <= 0xFFFF) {
+            byte(0xcd);
+            be16(v);
+        } else {
+            byte(0xce);
+            be32(v);
+        }
+    }
+
+    void float32(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        byte(0xca);
+        be32(bits);
+    }
+
+private:
+    void byte(uint32_t b) { out.push_back((char)(uint8_t)b); }
+
+    void be16(uint32_t v) {
+        byte(v >> 8);
+        byte(v);
+    }
+
+    void be32(uint32_t v) {
+        byte(v >> 24);
+        byte(v >> 16);
+        byte(v >> 8);
+        byte(v);
+    }
+
+    std::string& out;
+};
+
+#endif //STEAMSEARCH_MSGPACKWRITER_H
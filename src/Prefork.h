@@ -0,0 +1,132 @@
+#ifndef STEAMSEARCH_PREFORK_H
+#define STEAMSEARCH_PREFORK_H
+
+// Pre-fork serving, WORKERS=N on Linux. The supervisor loads the catalog once and forks N worker
+// processes, which share its pages copy-on-write because nothing writes the catalog after startup.
+// Each worker runs its own Crow app, allocator and accept loop on the same port with SO_REUSEPORT,
+// so the kernel spreads connections over the workers. A worker that dies is forked again.
+//
+// Defines bind(), so only steam_server's translation unit may include it.
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef __THROW
+#define __THROW
+#endif
+
+inline bool preforkReusePort = false;
+
+// Crow binds its acceptor itself and has no SO_REUSEPORT option, so once workers are forked every
+// bind of this process comes through here and stream sockets get the option first
+extern "C" int bind(int fd, const struct sockaddr* addr, socklen_t len) __THROW {
+    using BindFn = int (*)(int, const struct sockaddr*, socklen_t);
+    static BindFn realBind = (BindFn)dlsym(RTLD_NEXT, "bind");
+
+    if (preforkReusePort) {
+        int type = 0;
+        socklen_t typeLen = sizeof(type);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &typeLen) == 0 && type == SOCK_STREAM) {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        }
+    }
+    return realBind(fd, addr, len);
+}
+
+// worker pids by index, -1 while a slot is empty. Sized before the signal handler is installed.
+inline std::vector<pid_t> preforkPids;
+inline volatile sig_atomic_t preforkStopping = 0;
+
+// SIGINT / SIGTERM on the supervisor stop every worker (only async-signal-safe calls in here)
+inline void preforkStop(int) {
+    preforkStopping = 1;
+    for (pid_t pid : preforkPids) {
+        if (pid > 0) kill(pid, SIGTERM);
+    }
+}
+
+// Forks the workers and restarts any that exit. Returns the worker's index in each worker, and -1
+// in the supervisor once a stop signal has ended every worker.
+inline int superviseWorkers(int workers) {
+    preforkReusePort = true;
+    preforkPids.assign(workers, -1);
+    std::vector<std::chrono::steady_clock::time_point> started(workers);
+    pid_t supervisor = getpid();
+
+    struct sigaction stop {};
+    stop.sa_handler = preforkStop;
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGINT, &stop, nullptr);
+    sigaction(SIGTERM, &stop, nullptr);
+
+    // true in the new worker
+    auto spawn = [&](int i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "ERROR: Could not fork worker " << i << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (pid == 0) {
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            // a worker never outlives its supervisor
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != supervisor) _exit(0);
+            return true;
+        }
+        preforkPids[i] = pid;
+        started[i] = std::chrono::steady_clock::now();
+        // the stop signal may have arrived while the slot was still empty
+        if (preforkStopping) kill(pid, SIGTERM);
+        return false;
+    };
+
+    for (int i = 0; i < workers; i++) {
+        if (spawn(i)) return i;
+    }
+    std::cout << "Supervisor " << supervisor << " started " << workers << " workers" << std::endl;
+
+    for (;;) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break; // ECHILD, every worker is gone
+        }
+        auto slot = std::find(preforkPids.begin(), preforkPids.end(), pid);
+        if (slot == preforkPids.end()) continue;
+        int i = (int)(slot - preforkPids.begin());
+        *slot = -1;
+        if (preforkStopping) continue;
+
+        if (WIFSIGNALED(status)) {
+            std::cerr << "WARNING: Worker " << i << " (pid " << pid << ") killed by signal " << WTERMSIG(status) << ", restarting" << std::endl;
+        } else {
+            std::cerr << "WARNING: Worker " << i << " (pid " << pid << ") exited with " << WEXITSTATUS(status) << ", restarting" << std::endl;
+        }
+
+        // a worker that dies right after starting is restarted after a pause rather than in a tight loop
+        if (std::chrono::steady_clock::now() - started[i] < std::chrono::seconds(1)) std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (preforkStopping) continue;
+        if (spawn(i)) return i;
+    }
+    return -1;
+}
+
+#endif
+
+#endif //STEAMSEARCH_PREFORK_H
@@ -0,0 +1,111 @@
+#ifndef STEAMSEARCH_RESULTSTORE_H
+#define STEAMSEARCH_RESULTSTORE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Hash.h"
+
+// (score, index into globalGames), sorted best first
+using ScoredList = std::vector<std::pair<float, int>>;
+
+// Bounded LRU keyed by a canonical request key. Entries expire after a TTL and the store evicts
+// least recently used entries once it holds too many of them or their total size() passes
+// maxSize, so a miss only ever costs recomputing the value.
+template <typename Value>
+class BoundedStore {
+public:
+    BoundedStore(size_t maxEntries, size_t maxSize, std::chrono::seconds ttl)
+        : maxEntries(maxEntries), maxSize(maxSize), ttl(ttl) {}
+
+    std::shared_ptr<const Value> get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+
+        if (std::chrono::steady_clock::now() > it->second->expires) {
+            erase(it->second);
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->value;
+    }
+
+    void put(const std::string& key, std::shared_ptr<const Value> value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) erase(it->second);
+
+        // a value bigger than the whole budget is never worth keeping
+        if (value->size() > maxSize) return;
+
+        lru.push_front({key, value, std::chrono::steady_clock::now() + ttl});
+        index[key] = lru.begin();
+        totalSize += value->size();
+
+        while (lru.size() > maxEntries || totalSize > maxSize) erase(std::prev(lru.end()));
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const Value> value;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    void erase(typename std::list<Entry>::iterator it) {
+        totalSize -= it->value->size();
+        index.erase(it->key);
+        lru.erase(it);
+    }
+
+    size_t maxEntries;
+    size_t maxSize;
+    std::chrono::seconds ttl;
+    size_t totalSize = 0;
+
+    std::mutex mutex;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+};
+
+// scored candidate lists for cursor pagination, sized in candidates
+using ResultStore = BoundedStore<ScoredList>;
+
+// A finished, compressed response page, sized in body bytes
+struct CachedPage {
+    std::string body;
+    std::string nextCursor;
+
+    size_t size() const { return body.size(); }
+};
+
+using PageCache = BoundedStore<CachedPage>;
+
+// A cursor is the next offset plus a hash of the request key it belongs to, as 16 hex digits
+inline std::string encodeCursor(const std::string& key, size_t offset) {
+    uint64_t packed = ((uint64_t)offset << 32) | (hashKey(key) & 0xFFFFFFFFULL);
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)packed);
+    return buf;
+}
+
+inline bool decodeCursor(const std::string& key, const char* cursor, size_t& offset) {
+    char* end = nullptr;
+    unsigned long long packed = std::strtoull(cursor, &end, 16);
+    if (end == cursor || *end != '\0' || std::strlen(cursor) != 16) return false;
+    if ((packed & 0xFFFFFFFFULL) != (hashKey(key) & 0xFFFFFFFFULL)) return false;
+    offset = (size_t)(packed >> 32);
+    return true;
+}
+
+#endif //STEAMSEARCH_RESULTSTORE_H
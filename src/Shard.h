@@ -0,0 +1,149 @@
+#ifndef STEAMSEARCH_SHARD_H
+#define STEAMSEARCH_SHARD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompactGame.h"
+#include "TagVotes.h"
+
+// Binary bodies exchanged between steam_coordinator and the shard servers. Fields are raw native
+// endian values, every process of a cluster runs the same build. Every body comes with the
+// shard's dataset version in hex, X-Dataset-Version.
+//
+// target, GET /shard/target/<id> (404 on the shards that do not hold the game):
+//   CompactGame game
+//   uint32_t voteCount
+//   TagWeight votes[voteCount]
+//
+// partial top-K, POST /shard/recommend/<algorithm> with a target as body (no hits for an unknown
+// algorithm) and GET /shard/search/<query>:
+//   uint32_t hitCount
+//   uint32_t flags                     SHARD_PARTIAL when the shard's scan ran out of time
+//   uint64_t matched                   results the shard has in total, hitCount is at most ?k=
+//   hits[hitCount], each:
+//     float score
+//     uint32_t catalogIndex            position in the whole catalog, breaks score ties
+//     uint32_t itemBytes
+//     item                             the rendered result, a JSON object or a MessagePack map
+
+constexpr uint32_t SHARD_PARTIAL = 1;
+
+struct ShardTarget {
+    CompactGame game;
+    std::vector<TagWeight> votes;
+};
+
+inline void encodeShardTarget(std::string& out, const CompactGame& game, const TagWeight* votes, uint32_t voteCount) {
+    out.append((const char*)&game, sizeof(game));
+    out.append((const char*)&voteCount, sizeof(voteCount));
+    out.append((const char*)votes, voteCount * sizeof(TagWeight));
+}
+
+inline bool decodeShardTarget(const std::string& body, ShardTarget& target) {
+    uint32_t voteCount = 0;
+    if (body.size() < sizeof(CompactGame) + sizeof(voteCount)) return false;
+    std::memcpy(&target.game, body.data(), sizeof(CompactGame));
+    std::memcpy(&voteCount, body.data() + sizeof(CompactGame), sizeof(voteCount));
+    if (body.size() != sizeof(CompactGame) + sizeof(voteCount) + voteCount * sizeof(TagWeight)) return false;
+    target.votes.resize(voteCount);
+    std::memcpy(target.votes.data(), body.data() + sizeof(CompactGame) + sizeof(voteCount), voteCount * sizeof(TagWeight));
+    return true;
+}
+
+// Builds a partial top-K page: begin, then per hit beginHit, render the item straight into out,
+// endHit, and finish once every hit is written
+class ShardPageWriter {
+public:
+    explicit ShardPageWriter(std::string& out) : out(out) { out.append(HEADER_BYTES, '\0'); }
+
+    void beginHit(float score, uint32_t catalogIndex) {
+        out.append((const char*)&score, sizeof(score));
+        out.append((const char*)&catalogIndex, sizeof(catalogIndex));
+        lengthAt = out.size();
+        out.append(sizeof(uint32_t), '\0');
+    }
+
+    void endHit() {
+        uint32_t itemBytes = (uint32_t)(out.size() - lengthAt - sizeof(uint32_t));
+        std::memcpy(&out[lengthAt], &itemBytes, sizeof(itemBytes));
+        hitCount++;
+    }
+
+    void finish(uint32_t flags, uint64_t matched) {
+        std::memcpy(&out[0], &hitCount, sizeof(hitCount));
+        std::memcpy(&out[4], &flags, sizeof(flags));
+        std::memcpy(&out[8], &matched, sizeof(matched));
+    }
+
+    static constexpr size_t HEADER_BYTES = 16;
+
+private:
+    std::string& out;
+    size_t lengthAt = 0;
+    uint32_t hitCount = 0;
+};
+
+struct ShardHit {
+    float score;
+    uint32_t catalogIndex;
+    std::string_view item; // points into the page body
+};
+
+struct ShardPage {
+    uint32_t flags = 0;
+    uint64_t matched = 0;
+    std::vector<ShardHit> hits;
+};
+
+// false on a malformed body, the hits stay valid as long as body does
+inline bool decodeShardPage(const std::string& body, ShardPage& page) {
+    if (body.size() < ShardPageWriter::HEADER_BYTES) return false;
+    uint32_t hitCount;
+    std::memcpy(&hitCount, body.data(), sizeof(hitCount));
+    std::memcpy(&page.flags, body.data() + 4, sizeof(page.flags));
+    std::memcpy(&page.matched, body.data() + 8, sizeof(page.matched));
+
+    size_t pos = ShardPageWriter::HEADER_BYTES;
+    page.hits.clear();
+    page.hits.reserve(std::min<size_t>(hitCount, body.size() / 12));
+    for (uint32_t i = 0; i < hitCount; i++) {
+        if (body.size() - pos < 12) return false;
+        ShardHit hit;
+        uint32_t itemBytes;
+        std::memcpy(&hit.score, body.data() + pos, 4);
+        std::memcpy(&hit.catalogIndex, body.data() + pos + 4, 4);
+        std::memcpy(&itemBytes, body.data() + pos + 8, 4);
+        pos += 12;
+        if (body.size() - pos < itemBytes) return false;
+        hit.item = std::string_view(body.data() + pos, itemBytes);
+        pos += itemBytes;
+        page.hits.push_back(hit);
+    }
+    return pos == body.size();
+}
+
+// Hits [offset, offset + count) of the merged ranking. Ranked pages order like rankByScore on the
+// whole catalog (score, then catalog index, both descending), unranked ones (search) by catalog index.
+inline std::vector<const ShardHit*> mergeShardPages(const std::vector<ShardPage>& pages, size_t offset, size_t count,
+                                                    bool ranked) {
+    std::vector<const ShardHit*> merged;
+    for (const auto& page : pages) {
+        for (const auto& hit : page.hits) merged.push_back(&hit);
+    }
+
+    auto before = [ranked](const ShardHit* a, const ShardHit* b) {
+        if (!ranked) return a->catalogIndex < b->catalogIndex;
+        if (a->score != b->score) return a->score > b->score;
+        return a->catalogIndex > b->catalogIndex;
+    };
+    size_t end = std::min(merged.size(), offset + count);
+    if (offset >= end) return {};
+    std::partial_sort(merged.begin(), merged.begin() + end, merged.end(), before);
+    return std::vector<const ShardHit*>(merged.begin() + offset, merged.begin() + end);
+}
+
+#endif //STEAMSEARCH_SHARD_H
@@ -0,0 +1,92 @@
+#ifndef STEAMSEARCH_SIGNATURES_H
+#define STEAMSEARCH_SIGNATURES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "CompactGame.h"
+#include "TagVotes.h"
+
+// Tag vocabulary and the per-game signatures derived from a game's tag votes. The converter and
+// the synthetic generator share it so generated games score exactly like converted ones.
+struct TagSignatures {
+    std::vector<std::string> tagNames;
+    std::unordered_map<std::string, int> tagToIndex;
+    std::vector<std::vector<int>> hashCombinations;
+
+    // reads one tag per line and seeds the 150 MinHash permutations, false when the file is missing
+    bool load(const std::string& tagsPath) {
+        std::ifstream tagFile(tagsPath);
+        if (!tagFile.is_open()) return false;
+
+        std::string line;
+        while (std::getline(tagFile, line)) {
+            if (!line.empty()) {
+                tagToIndex[line] = (int)tagNames.size();
+                tagNames.push_back(line);
+            }
+        }
+
+        int tagCount = (int)tagNames.size();
+        std::vector<int> baseIndices(tagCount);
+        for (int i = 0; i < tagCount; i++) {
+            baseIndices[i] = i;
+        }
+
+        std::mt19937 g(42);
+        for (int i = 0; i < 150; i++) {
+            std::vector<int> shuffled = baseIndices;
+            std::shuffle(shuffled.begin(), shuffled.end(), g);
+            hashCombinations.push_back(shuffled);
+        }
+        return true;
+    }
+
+    // tagBits, cosine and MinHash signatures from (tag index, votes) pairs, in the given order
+    void fill(CompactGame& cg, const std::vector<std::pair<int, int>>& votes) const {
+        for (auto& [idx, count] : votes) {
+            if (idx < 256) {
+                cg.tagBits[idx / 32] |= (1U << (idx % 32));
+            }
+
+            uint32_t bucket = std::hash<int>{}(idx) % 128;
+            cg.cosineSignature[bucket] += static_cast<float>(count);
+        }
+
+        for (int i = 0; i < 150; i++) {
+            int minVal = 999999;
+            for (auto& [idx, count] : votes) {
+                if (hashCombinations[i][idx] < minVal) minVal = hashCombinations[i][idx];
+            }
+            cg.minHashSignature[i] = votes.empty() ? 0 : minVal;
+        }
+
+        float sumSq = 0;
+        for (int i = 0; i < 128; i++) sumSq += cg.cosineSignature[i] * cg.cosineSignature[i];
+        if (sumSq > 0) {
+            float invRoot = 1.0f / std::sqrt(sumSq);
+            for (int i = 0; i < 128; i++) cg.cosineSignature[i] *= invRoot;
+        }
+    }
+};
+
+// Appends one game's normalized tag weights for tagvotes.bin, sorted by tag, zero vote tags skipped
+inline void appendTagWeights(std::vector<std::pair<int, int>> votes, std::vector<TagWeight>& entries) {
+    long long totalVotes = 0;
+    for (auto& [idx, count] : votes) totalVotes += count;
+    std::sort(votes.begin(), votes.end());
+    for (auto& [idx, count] : votes) {
+        if (count <= 0) continue;
+        uint16_t weight = static_cast<uint16_t>(std::lround(count * TAG_WEIGHT_SCALE / totalVotes));
+        entries.push_back({static_cast<uint16_t>(idx), weight});
+    }
+}
+
+#endif //STEAMSEARCH_SIGNATURES_H
@@ -0,0 +1,55 @@
+#ifndef STEAMSEARCH_SLOWLOG_H
+#define STEAMSEARCH_SLOWLOG_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Metrics.h"
+
+// One request that went over the slow threshold, with enough detail to replay it
+struct SlowRequest {
+    int64_t timeUs;
+    int series;
+    int code;
+    uint32_t appId;
+    std::string url;
+    double seconds;
+    uint64_t candidates;
+    uint64_t results;
+    double stageSeconds[(int)Stage::COUNT];
+};
+
+// The most recent slow requests, oldest dropped first. Only slow requests take the lock, so the
+// common path never touches it.
+class SlowLog {
+public:
+    explicit SlowLog(size_t capacity) : capacity(capacity) {}
+
+    void record(SlowRequest request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back(std::move(request));
+        if (entries.size() > capacity) entries.pop_front();
+        total++;
+    }
+
+    // newest first
+    std::vector<SlowRequest> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::vector<SlowRequest>(entries.rbegin(), entries.rend());
+    }
+
+    uint64_t recorded() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return total;
+    }
+
+private:
+    size_t capacity;
+    std::mutex mutex;
+    std::deque<SlowRequest> entries;
+    uint64_t total = 0;
+};
+
+#endif //STEAMSEARCH_SLOWLOG_H
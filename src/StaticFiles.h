@@ -0,0 +1,124 @@
+#ifndef STEAMSEARCH_STATICFILES_H
+#define STEAMSEARCH_STATICFILES_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include "Compression.h"
+#include "Hash.h"
+
+// One file of the built frontend with its precompressed variants
+struct StaticAsset {
+    std::string body;
+    std::string gzipBody;   // from file.gz, or compressed at load for text types
+    std::string brotliBody; // from file.br when the build produced one
+    std::string contentType;
+    std::string etag;       // one per representation
+    std::string gzipEtag;
+    std::string brotliEtag;
+    bool immutable;         // hashed file under assets/, safe to cache forever
+};
+
+// The whole frontend build (a few MB) held in memory. Crow's connection does not expose its socket,
+// so sendfile is not an option, serving from RAM keeps requests to a lookup and a copy with no
+// disk I/O and no per-request compression.
+class StaticFiles {
+public:
+    void load(const std::filesystem::path& root) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        if (!fs::is_directory(root, ec)) {
+            std::cerr << "WARNING: No frontend build at " << root.string() << ", static serving disabled" << std::endl;
+            return;
+        }
+
+        size_t totalBytes = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+            if (!entry.is_regular_file()) continue;
+            std::string ext = entry.path().extension().string();
+            if (ext == ".gz" || ext == ".br") continue;
+
+            StaticAsset asset;
+            asset.body = readFile(entry.path());
+            asset.gzipBody = readFile(entry.path().string() + ".gz");
+            asset.brotliBody = readFile(entry.path().string() + ".br");
+            asset.contentType = contentTypeFor(ext);
+            if (asset.gzipBody.empty() && isText(ext) && asset.body.size() >= COMPRESS_MIN_BYTES) {
+                asset.gzipBody = gzipCompress(asset.body, 9);
+            }
+
+            std::string url = "/" + fs::relative(entry.path(), root, ec).generic_string();
+            asset.immutable = url.rfind("/assets/", 0) == 0;
+            asset.etag = makeETag(asset.body, "");
+            asset.gzipEtag = makeETag(asset.body, "-gzip");
+            asset.brotliEtag = makeETag(asset.body, "-br");
+
+            totalBytes += asset.body.size() + asset.gzipBody.size() + asset.brotliBody.size();
+            assets[url] = std::move(asset);
+        }
+        std::cout << "Loaded " << assets.size() << " frontend files (" << totalBytes << " bytes) from " << root.string() << std::endl;
+    }
+
+    // the asset at url, "/" is index.html
+    const StaticAsset* find(const std::string& url) const {
+        if (url.find("..") != std::string::npos) return nullptr;
+        auto it = assets.find(url == "/" ? "/index.html" : url);
+        return it != assets.end() ? &it->second : nullptr;
+    }
+
+    // index.html for an extensionless client side route, never for a path under the API routes
+    const StaticAsset* fallback(const std::string& url) const {
+        for (const char* prefix : {"/search", "/recommend", "/shard", "/debug", "/metrics"}) {
+            size_t n = std::strlen(prefix);
+            if (url.compare(0, n, prefix) == 0 && (url.size() == n || url[n] == '/' || url[n] == '?')) return nullptr;
+        }
+        std::string last = url.substr(url.find_last_of('/') + 1);
+        if (last.find('.') != std::string::npos) return nullptr;
+        auto it = assets.find("/index.html");
+        return it != assets.end() ? &it->second : nullptr;
+    }
+
+    bool empty() const { return assets.empty(); }
+
+private:
+    static std::string readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return "";
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    // strong validators must differ per representation, so each encoding gets its own suffix
+    static std::string makeETag(const std::string& body, const char* encoding) {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "\"%016llx%s\"", (unsigned long long)hashKey(body), encoding);
+        return buf;
+    }
+
+    static bool isText(const std::string& ext) {
+        return ext == ".html" || ext == ".js" || ext == ".css" || ext == ".svg" || ext == ".json" || ext == ".txt" || ext == ".map";
+    }
+
+    static std::string contentTypeFor(const std::string& ext) {
+        static const std::unordered_map<std::string, std::string> types = {
+            {".html", "text/html; charset=utf-8"}, {".js", "text/javascript; charset=utf-8"},
+            {".css", "text/css; charset=utf-8"}, {".svg", "image/svg+xml"}, {".json", "application/json"},
+            {".png", "image/png"}, {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"}, {".gif", "image/gif"},
+            {".webp", "image/webp"}, {".ico", "image/x-icon"}, {".woff", "font/woff"}, {".woff2", "font/woff2"},
+            {".txt", "text/plain; charset=utf-8"}, {".map", "application/json"}
+        };
+        auto it = types.find(ext);
+        return it == types.end() ? "application/octet-stream" : it->second;
+    }
+
+    std::unordered_map<std::string, StaticAsset> assets;
+};
+
+#endif //STEAMSEARCH_STATICFILES_H
@@ -0,0 +1,17 @@
+#ifndef STEAMSEARCH_TAGVOTES_H
+#define STEAMSEARCH_TAGVOTES_H
+
+#include <cstdint>
+
+// Side file data/tagvotes.bin, written by the converter in the same game order as games_*.bin:
+//   uint32_t gameCount
+//   uint32_t offsets[gameCount + 1]   game i owns entries [offsets[i], offsets[i + 1])
+//   TagWeight entries[]               sorted by tag within each game
+struct TagWeight {
+    uint16_t tag;
+    uint16_t weight; // share of the game's tag votes, scaled by TAG_WEIGHT_SCALE
+};
+
+constexpr float TAG_WEIGHT_SCALE = 65535.0f;
+
+#endif //STEAMSEARCH_TAGVOTES_H
@@ -0,0 +1,223 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include "Catalog.h"
+
+// Micro-benchmarks for the scoring kernels, the catalog scan, top-K selection, response rendering
+// and /search matching, run over the real catalog or an in-memory synthetic one:
+//
+//   steam_bench [--data <dir>] [--synthetic <games>] [--min-time <seconds>] [--filter <prefix>]
+//
+// Each benchmark repeats until it has run for --min-time and reports ns per op and, where an op
+// has a natural byte count, GB/s.
+
+double minSeconds = 0.5;
+std::string onlyPrefix;
+
+// keeps results alive so the optimizer cannot drop the work that produced them
+volatile uint64_t benchSink = 0;
+
+template <typename T>
+void keep(const T& value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, std::min(sizeof(bits), sizeof(value)));
+    benchSink = benchSink + bits;
+}
+
+// run() performs one batch and returns how many ops it did, bytesPerOp feeds the GB/s column
+void bench(const std::string& name, double bytesPerOp, const std::function<uint64_t()>& run) {
+    if (!onlyPrefix.empty() && name.compare(0, onlyPrefix.size(), onlyPrefix) != 0) return;
+
+    run();  // warm caches and the allocator
+    uint64_t ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        ops += run();
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < minSeconds);
+
+    double nsPerOp = elapsed.count() * 1e9 / (double)ops;
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(14) << ops
+              << std::setw(14) << std::fixed << std::setprecision(2) << nsPerOp;
+    if (bytesPerOp > 0) {
+        std::cout << std::setw(12) << std::setprecision(3) << bytesPerOp / nsPerOp;
+    } else {
+        std::cout << std::setw(12) << "-";
+    }
+    std::cout << std::endl;
+}
+
+// Uniformly random games, enough to exercise every code path without the real data files
+void makeSyntheticCatalog(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    globalGames.assign(count, CompactGame{});
+    globalStringPool.assign(1, '\0');
+    auto intern = [](const std::string& s) {
+        uint32_t offset = (uint32_t)globalStringPool.size();
+        globalStringPool.insert(globalStringPool.end(), s.begin(), s.end());
+        globalStringPool.push_back('\0');
+        return offset;
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        CompactGame& g = globalGames[i];
+        g.id = (uint32_t)(10 + i * 10);
+        g.reviewScore = unit(rng);
+        g.metacriticScore = (int16_t)(unit(rng) < 0.2f ? 40 + rng() % 60 : -1);
+        g.price = roundToTwo(unit(rng) * 60.0f);
+
+        for (int t = 0, tags = 5 + rng() % 15; t < tags; t++) {
+            int tag = rng() % 256;
+            g.tagBits[tag / 32] |= 1u << (tag % 32);
+        }
+        for (int k = 0; k < 150; k++) g.minHashSignature[k] = rng();
+        for (int k = 0; k < 128; k++) g.cosineSignature[k] = unit(rng);
+
+        g.nameOffset = intern("Synthetic Game " + std::to_string(i));
+        g.imageUrlOffset = intern("https://cdn.example.com/apps/" + std::to_string(g.id) + "/header.jpg");
+        g.developerOffset = intern("Developer " + std::to_string(rng() % 5000));
+        g.publisherOffset = intern("Publisher " + std::to_string(rng() % 3000));
+    }
+    std::cout << "Generated " << count << " synthetic games" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string dataDir;
+    size_t syntheticGames = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--data") dataDir = argv[i + 1];
+        else if (flag == "--synthetic") syntheticGames = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--min-time") minSeconds = std::atof(argv[i + 1]);
+        else if (flag == "--filter") onlyPrefix = argv[i + 1];
+        else {
+            std::cerr << "Unknown flag " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    if (syntheticGames > 0) {
+        makeSyntheticCatalog(syntheticGames, 42);
+    } else {
+        loadData(dataDir);
+    }
+    if (globalGames.empty()) {
+        std::cerr << "ERROR: No games loaded, pass --data <dir> or --synthetic <games>" << std::endl;
+        return 1;
+    }
+    buildIndexes();
+    buildFragments();
+
+    const size_t n = globalGames.size();
+    const CompactGame& target = globalGames[n / 2];
+    const int targetIdx = (int)(n / 2);
+    ScanFilter noFilter;
+
+    std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(14) << "ops"
+              << std::setw(14) << "ns/op" << std::setw(12) << "GB/s" << std::endl;
+
+    // kernels: one op is one candidate, bytes are the candidate fields the kernel reads
+    bench("kernel/jaccard", sizeof(target.tagBits), [&] {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++) sum += getJaccard(target, globalGames[i]);
+        keep(sum);
+        return (uint64_t)n;
+    });
+    bench("kernel/minhash", sizeof(target.minHashSignature), [&] {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++) sum += getMinHash(target, globalGames[i]);
+        keep(sum);
+        return (uint64_t)n;
+    });
+    bench("kernel/cosine", sizeof(target.cosineSignature), [&] {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++) sum += getCosine(target, globalGames[i]);
+        keep(sum);
+        return (uint64_t)n;
+    });
+    bench("kernel/global", sizeof(CompactGame), [&] {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++) sum += getGlobalScore(target, globalGames[i]);
+        keep(sum);
+        return (uint64_t)n;
+    });
+
+    // full catalog scans as the routes run them, one op is one game
+    bench("scan/global", sizeof(CompactGame), [&] {
+        keep(scanCatalog(noFilter, {targetIdx}, 0.15f, [&](const CompactGame& g) { return getGlobalScore(target, g); }).size());
+        return (uint64_t)n;
+    });
+    bench("scan/jaccard", sizeof(CompactGame), [&] {
+        keep(scanCatalog(noFilter, {targetIdx}, 0.1f, [&](const CompactGame& g) { return getJaccard(target, g); }).size());
+        return (uint64_t)n;
+    });
+    ScanFilter cheapGames;
+    cheapGames.maxPrice = 10.0f;
+    cheapGames.minReview = 0.8f;
+    cheapGames.active = true;
+    bench("scan/global_filtered", 0, [&] {
+        keep(scanCatalog(cheapGames, {targetIdx}, 0.15f, [&](const CompactGame& g) { return getGlobalScore(target, g); }).size());
+        return (uint64_t)n;
+    });
+
+    // top-K over one scan's candidates, one op is one candidate
+    ScoredList candidates = scanCatalog(noFilter, {targetIdx}, 0.0f, [&](const CompactGame& g) { return getGlobalScore(target, g); });
+    std::cout << "(" << candidates.size() << " candidates for top-K)" << std::endl;
+    if (!candidates.empty()) {
+        bench("topk/rank_by_score", sizeof(ScoredList::value_type), [&] {
+            keep(rankByScore(candidates).front().second);
+            return (uint64_t)candidates.size();
+        });
+        bench("topk/partial_sort_90", sizeof(ScoredList::value_type), [&] {
+            ScoredList copy = candidates;
+            size_t k = std::min<size_t>(90, copy.size());
+            std::partial_sort(copy.begin(), copy.begin() + k, copy.end(), std::greater<>());
+            keep(copy.front().second);
+            return (uint64_t)copy.size();
+        });
+    }
+
+    // rendering a 90 result page, one op is one page, bytes are the bytes written
+    ScoredList ranked = rankByScore(candidates);
+    std::string body;
+    renderResults(body, ranked, 0, 90, "global_weighted", ALL_FIELDS);
+    bench("render/json_full", (double)body.size(), [&] {
+        body.clear();
+        renderResults(body, ranked, 0, 90, "global_weighted", ALL_FIELDS);
+        return (uint64_t)1;
+    });
+    body.clear();
+    renderResults(body, ranked, 0, 90, "global_weighted", LEAN_FIELDS);
+    bench("render/json_lean", (double)body.size(), [&] {
+        body.clear();
+        renderResults(body, ranked, 0, 90, "global_weighted", LEAN_FIELDS);
+        return (uint64_t)1;
+    });
+    body.clear();
+    renderResultsMsgPack(body, ranked, 0, 90, "global_weighted", ALL_FIELDS);
+    bench("render/msgpack_full", (double)body.size(), [&] {
+        body.clear();
+        renderResultsMsgPack(body, ranked, 0, 90, "global_weighted", ALL_FIELDS);
+        return (uint64_t)1;
+    });
+
+    // /search matching, one op is one query; a miss walks every name
+    for (const char* query : {"the", "portal", "zzzzqx"}) {
+        bench(std::string("search/") + query, 0, [&] {
+            body.clear();
+            keep(searchByName(body, query, 15));
+            return (uint64_t)1;
+        });
+    }
+
+    return 0;
+}
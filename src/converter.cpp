@@ -7,6 +7,8 @@
 #include <random>
 #include <nlohmann/json.hpp>
 #include "CompactGame.h"
+#include "TagVotes.h"
+#include "Signatures.h"
 
 using json = nlohmann::json;
 
@@ -14,9 +16,8 @@ using json = nlohmann::json;
 std::vector<char> stringPool;
 std::unordered_map<std::string, uint32_t> stringCache;
 
-// setupMinHash
-std::unordered_map<std::string, int> tagToIndex;
-std::vector<std::vector<int>> hashCombinations;
+// tag vocabulary and MinHash permutations
+TagSignatures signatures;
 
 uint32_t addToPool(const std::string& str) {
     if (str.empty()) {
@@ -38,32 +39,8 @@ uint32_t addToPool(const std::string& str) {
     return offset;
 }
 
-void setupMinHash() {
-    std::ifstream tagFile("data/tags.txt");
-    std::string line;
-    int tagCount = 0;
-
-    while (std::getline(tagFile, line)) {
-        if (!line.empty()) {
-            tagToIndex[line] = tagCount++;
-        }
-    }
-
-    std::vector<int> baseIndices(tagCount);
-    for (int i = 0; i < tagCount; i++) {
-        baseIndices[i] = i;
-    }
-
-    std::mt19937 g(42);
-    for (int i = 0; i < 150; i++) {
-        std::vector<int> shuffled = baseIndices;
-        std::shuffle(shuffled.begin(), shuffled.end(), g);
-        hashCombinations.push_back(shuffled);
-    }
-}
-
 void runConversion() {
-    setupMinHash();
+    signatures.load("data/tags.txt");
     std::ifstream f("data/games.json");
     json data = json::parse(f);
     
@@ -73,6 +50,10 @@ void runConversion() {
     
     int totalProcessed = 0;
 
+    // normalized tag votes for the weighted jaccard side file
+    std::vector<uint32_t> voteOffsets = {0};
+    std::vector<TagWeight> voteEntries;
+
     if (stringPool.empty()) stringPool.push_back('\0');
 
     for (auto& [id_str, info] : data.items()) {
@@ -102,36 +83,16 @@ void runConversion() {
         cg.genresOffset = addToPool(genreStr);
 
         auto gameTags = info.value("tags", json::object());
-        std::vector<int> currentTagIndices;
+        std::vector<std::pair<int, int>> currentVotes;
 
         for (auto& [tagName, count] : gameTags.items()) {
-            if (tagToIndex.count(tagName)) {
-                int idx = tagToIndex[tagName];
-                currentTagIndices.push_back(idx);
-
-                if (idx < 256) {
-                    cg.tagBits[idx / 32] |= (1U << (idx % 32));
-                }
-
-                uint32_t bucket = std::hash<int>{}(idx) % 128;
-                cg.cosineSignature[bucket] += static_cast<float>(count.get<int>());
-            }
+            auto tag = signatures.tagToIndex.find(tagName);
+            if (tag != signatures.tagToIndex.end()) currentVotes.push_back({tag->second, count.get<int>()});
         }
 
-        for (int i = 0; i < 150; i++) {
-            int minVal = 999999;
-            for (int tagIdx : currentTagIndices) {
-                if (hashCombinations[i][tagIdx] < minVal) minVal = hashCombinations[i][tagIdx];
-            }
-            cg.minHashSignature[i] = (currentTagIndices.empty()) ? 0 : minVal;
-        }
-
-        float sumSq = 0;
-        for (int i = 0; i < 128; i++) sumSq += cg.cosineSignature[i] * cg.cosineSignature[i];
-        if (sumSq > 0) {
-            float invRoot = 1.0f / std::sqrt(sumSq);
-            for (int i = 0; i < 128; i++) cg.cosineSignature[i] *= invRoot;
-        }
+        signatures.fill(cg, currentVotes);
+        appendTagWeights(currentVotes, voteEntries);
+        voteOffsets.push_back(static_cast<uint32_t>(voteEntries.size()));
 
         // 55,000 games
         if (totalProcessed < 55000) {
@@ -150,8 +111,16 @@ void runConversion() {
     outStrings.write(stringPool.data(), stringPool.size());
     outStrings.close();
 
+    std::ofstream outVotes("data/tagvotes.bin", std::ios::binary);
+    uint32_t gameCount = static_cast<uint32_t>(totalProcessed);
+    outVotes.write(reinterpret_cast<const char*>(&gameCount), sizeof(gameCount));
+    outVotes.write(reinterpret_cast<const char*>(voteOffsets.data()), voteOffsets.size() * sizeof(uint32_t));
+    outVotes.write(reinterpret_cast<const char*>(voteEntries.data()), voteEntries.size() * sizeof(TagWeight));
+    outVotes.close();
+
     std::cout << "Successfully converted " << totalProcessed << " games." << std::endl;
     std::cout << "Data split into games_1.bin and games_2.bin" << std::endl;
+    std::cout << "Wrote " << voteEntries.size() << " tag votes to tagvotes.bin" << std::endl;
 }
 
 void verifyConversion() {
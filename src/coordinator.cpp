@@ -0,0 +1,379 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <poll.h>
+#include <crow.h>
+#include "Compression.h"
+#include "HttpClient.h"
+#include "HttpUtil.h"
+#include "MsgPackWriter.h"
+#include "ResultStore.h"
+#include "Shard.h"
+
+// Scatter-gather front end for a catalog split across steam_server shards (SHARD=i/N):
+//
+//   SHARDS=127.0.0.1:9001,127.0.0.1:9002 PORT=8080 ./steam_coordinator
+//
+// /recommend/global/<id> and /recommend/<algorithm>/<id> fetch the target's record from the shard
+// holding it, ask every shard for its best offset + limit results and merge them, so each page is
+// the one a single server over the whole catalog would return. /search merges the shards' first
+// matches in catalog order. Status codes, ETags and 304s follow steam_server, the ETags are built
+// from the shards' dataset versions. Seed, multi-feature and decision tree recommendations look at
+// several games or the whole catalog at once and are only served by an unsharded steam_server.
+
+struct ShardEndpoint {
+    std::string host;
+    int port;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> datasetVersion{0}; // X-Dataset-Version of its last page, 0 until one arrives
+};
+
+std::vector<std::unique_ptr<ShardEndpoint>> shards;
+
+// budget for a whole request, REQUEST_TIMEOUT_MS, the shards get what is left after the target lookup
+int timeoutMs = 2000;
+
+// part of the budget kept back from the shards' scans for sending and merging their pages
+constexpr int SHARD_REPLY_MARGIN_MS = 50;
+
+// deepest page served, the shards' MAX_SHARD_K
+constexpr size_t MAX_DEPTH = 5000;
+
+// target records by id (~1.2 KB each), saves the lookup round trip for popular games
+BoundedStore<std::string> targetCache(65536, 64 * 1024 * 1024, std::chrono::seconds(600));
+
+// one keep-alive connection per shard and worker thread
+std::vector<std::unique_ptr<HttpConnection>>& connections() {
+    thread_local std::vector<std::unique_ptr<HttpConnection>> perThread;
+    if (perThread.empty()) {
+        for (auto& shard : shards) perThread.push_back(std::make_unique<HttpConnection>(shard->host, shard->port, timeoutMs + 1000));
+    }
+    return perThread;
+}
+
+// Sends the request to every shard before reading any answer, so the shards scan in parallel, then
+// reads the answers in the order they arrive. A shard that is unreachable or has not answered by
+// the deadline is left with status 0 and its connection dropped, so its late answer is never read.
+std::vector<HttpResponse> fanOut(const char* method, const std::string& path, const std::string& body,
+                                 const std::string& headers, std::chrono::steady_clock::time_point deadline) {
+    auto& conns = connections();
+    std::vector<HttpResponse> responses(shards.size());
+    std::vector<size_t> waiting;
+    for (size_t i = 0; i < shards.size(); i++) {
+        shards[i]->requests++;
+        if (conns[i]->send(method, path, body, headers)) waiting.push_back(i);
+        else shards[i]->failures++;
+    }
+
+    std::vector<pollfd> fds;
+    while (!waiting.empty()) {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) break;
+        fds.clear();
+        for (size_t i : waiting) fds.push_back({conns[i]->handle(), POLLIN, 0});
+        int ready = poll(fds.data(), fds.size(), (int)left.count());
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) break;
+
+        size_t still = 0;
+        for (size_t k = 0; k < waiting.size(); k++) {
+            size_t i = waiting[k];
+            if (!fds[k].revents) {
+                waiting[still++] = i;
+            } else if (!conns[i]->receive(responses[i], deadline)) {
+                responses[i] = HttpResponse();
+                shards[i]->failures++;
+            } else if (responses[i].status == 200) {
+                std::string version = responses[i].header("X-Dataset-Version");
+                if (!version.empty()) shards[i]->datasetVersion = std::strtoull(version.c_str(), nullptr, 16);
+            }
+        }
+        waiting.resize(still);
+    }
+    for (size_t i : waiting) {
+        conns[i]->close();
+        shards[i]->failures++;
+    }
+    return responses;
+}
+
+// Version of the whole catalog, folded from the shards' own in shard order. 0 until every shard has
+// answered once, responses go out without an ETag until then.
+uint64_t catalogVersion() {
+    uint64_t version = FNV_OFFSET_BASIS;
+    for (auto& shard : shards) {
+        uint64_t shardVersion = shard->datasetVersion.load();
+        if (!shardVersion) return 0;
+        version = hashWords(&shardVersion, sizeof(shardVersion), version);
+    }
+    return version;
+}
+
+// the query string minus the coordinator's own parameters, passed on to the shards untouched
+std::string shardQuery(const crow::request& req) {
+    std::string query;
+    size_t start = req.raw_url.find('?');
+    if (start == std::string::npos) return query;
+
+    std::stringstream ss(req.raw_url.substr(start + 1));
+    std::string param;
+    while (std::getline(ss, param, '&')) {
+        std::string name = param.substr(0, param.find('='));
+        if (param.empty() || name == "limit" || name == "cursor" || name == "k") continue;
+        if (!query.empty()) query += '&';
+        query += param;
+    }
+    return query;
+}
+
+crow::response sendBody(const crow::request& req, std::string body, const char* contentType, const char* vary) {
+    std::string compressed;
+    if (body.size() >= COMPRESS_MIN_BYTES && acceptsGzip(req.get_header_value("Accept-Encoding"))) {
+        compressed = gzipCompress(body);
+    }
+    bool gzipped = !compressed.empty();
+
+    auto response = crow::response(gzipped ? std::move(compressed) : std::move(body));
+    response.add_header("Access-Control-Allow-Origin", "*");
+    response.add_header("Access-Control-Expose-Headers", "X-Next-Cursor, X-Partial-Results");
+    response.add_header("Content-Type", contentType);
+    response.add_header("Vary", vary);
+    if (gzipped) response.add_header("Content-Encoding", "gzip");
+    return response;
+}
+
+// partial pages are never cached, whole ones get an ETag once the catalog version is known
+void addCacheHeaders(crow::response& response, bool partial, const std::string& pageKey) {
+    uint64_t version = catalogVersion();
+    if (partial) {
+        response.add_header("X-Partial-Results", "true");
+        response.add_header("Cache-Control", "no-store");
+    } else if (version) {
+        addValidators(response, makeETag(version, pageKey));
+    } else {
+        response.add_header("Cache-Control", CACHE_CONTROL);
+    }
+}
+
+crow::response unavailable() {
+    crow::response response(503, "Shards unavailable, retry shortly");
+    response.add_header("Access-Control-Allow-Origin", "*");
+    response.add_header("Retry-After", "1");
+    response.add_header("Cache-Control", "no-store");
+    return response;
+}
+
+// Shards that answered 200 with a well formed page, partial is set for every other shard and for
+// shards whose scan ran out of time. 4xx answers are the same on every shard and returned as is.
+bool collectPages(std::vector<HttpResponse>& responses, std::vector<ShardPage>& pages, bool& partial,
+                  crow::response& error) {
+    for (auto& r : responses) {
+        ShardPage page;
+        if (r.status == 200 && decodeShardPage(r.body, page)) {
+            if (page.flags & SHARD_PARTIAL) partial = true;
+            pages.push_back(std::move(page));
+        } else if (r.status >= 400 && r.status < 500) {
+            error = crow::response(r.status, r.body);
+            return false;
+        } else {
+            partial = true;
+        }
+    }
+    if (pages.empty()) {
+        error = unavailable();
+        return false;
+    }
+    return true;
+}
+
+crow::response recommend(const crow::request& req, const std::string& type, int id) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    size_t limit = 90;
+    if (const char* rawLimit = req.url_params.get("limit")) {
+        char* end = nullptr;
+        long val = std::strtol(rawLimit, &end, 10);
+        if (end == rawLimit || *end != '\0' || val < 1 || val > 500) return crow::response(400, "Invalid limit");
+        limit = (size_t)val;
+    }
+
+    std::string query = shardQuery(req);
+    std::string key = type + "/" + std::to_string(id) + "?" + query;
+    size_t offset = 0;
+    if (const char* cursor = req.url_params.get("cursor")) {
+        if (!decodeCursor(key, cursor, offset)) return crow::response(400, "Invalid cursor");
+    }
+    if (offset + limit > MAX_DEPTH) return crow::response(400, "Page too deep");
+    bool msgpack = wantsMsgPack(req);
+    bool gzip = acceptsGzip(req.get_header_value("Accept-Encoding"));
+    std::string pageKey = key + "#" + std::to_string(offset) + "," + std::to_string(limit) +
+                          (msgpack ? ",msgpack" : ",json") + (gzip ? ",gzip" : "");
+
+    std::shared_ptr<const std::string> target = targetCache.get(std::to_string(id));
+    if (!target) {
+        bool unreachable = false;
+        for (auto& r : fanOut("GET", "/shard/target/" + std::to_string(id), "", "", deadline)) {
+            if (r.status == 200) target = std::make_shared<const std::string>(std::move(r.body));
+            else if (r.status != 404) unreachable = true;
+        }
+        if (!target) return unreachable ? unavailable() : crow::response(404, "Game not found");
+        targetCache.put(std::to_string(id), target);
+    }
+
+    // revalidation is answered before the shards are asked, once their versions are known
+    if (uint64_t version = catalogVersion()) {
+        std::string etag = makeETag(version, pageKey);
+        if (etagMatches(req, etag)) return notModified(etag, "Accept, Accept-Encoding");
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    std::string headers = "X-Request-Timeout-Ms: " + std::to_string(std::max<long long>(1, remaining.count() - SHARD_REPLY_MARGIN_MS)) + "\r\n";
+    if (msgpack) headers += "Accept: application/msgpack\r\n";
+    std::string path = "/shard/recommend/" + type + "?" + query + (query.empty() ? "" : "&") + "k=" + std::to_string(offset + limit);
+
+    // the pages point into the response bodies, which stay put until the merge is written out
+    std::vector<HttpResponse> responses = fanOut("POST", path, *target, headers, deadline);
+    std::vector<ShardPage> pages;
+    bool partial = false;
+    crow::response error;
+    if (!collectPages(responses, pages, partial, error)) return error;
+
+    uint64_t matched = 0;
+    for (const auto& page : pages) matched += page.matched;
+    auto hits = mergeShardPages(pages, offset, limit, true);
+
+    std::string body;
+    if (msgpack) {
+        MsgPackWriter w(body);
+        w.arrayHeader((uint32_t)hits.size());
+        for (const ShardHit* hit : hits) body.append(hit->item);
+    } else {
+        body += '[';
+        for (size_t i = 0; i < hits.size(); i++) {
+            if (i) body += ',';
+            body.append(hits[i]->item);
+        }
+        body += ']';
+    }
+
+    auto response = sendBody(req, std::move(body), msgpack ? "application/msgpack" : "application/json; charset=utf-8",
+                             "Accept, Accept-Encoding");
+    if (offset + limit < matched) response.add_header("X-Next-Cursor", encodeCursor(key, offset + limit));
+    addCacheHeaders(response, partial, pageKey);
+    return response;
+}
+
+crow::response notSharded() {
+    crow::response response(501, "Not available on a sharded catalog");
+    response.add_header("Access-Control-Allow-Origin", "*");
+    return response;
+}
+
+int main() {
+    const char* rawShards = std::getenv("SHARDS");
+    std::stringstream list(rawShards ? rawShards : "");
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t colon = item.rfind(':');
+        if (item.empty() || colon == std::string::npos) continue;
+        auto shard = std::make_unique<ShardEndpoint>();
+        shard->host = item.substr(0, colon);
+        shard->port = std::atoi(item.c_str() + colon + 1);
+        shards.push_back(std::move(shard));
+    }
+    if (shards.empty()) {
+        std::cerr << "ERROR: SHARDS must list the shard servers, e.g. 127.0.0.1:9001,127.0.0.1:9002" << std::endl;
+        return 1;
+    }
+    timeoutMs = envInt("REQUEST_TIMEOUT_MS", 2000);
+    int threads = envInt("WORKER_THREADS", (int)std::max(2u, std::thread::hardware_concurrency()));
+
+    crow::SimpleApp app;
+
+    CROW_ROUTE(app, "/search/<path>")
+    ([&](const crow::request& req, std::string query) {
+        std::string pageKey = "search/" + query + (acceptsGzip(req.get_header_value("Accept-Encoding")) ? ",gzip" : "");
+        if (uint64_t version = catalogVersion()) {
+            std::string etag = makeETag(version, pageKey);
+            if (etagMatches(req, etag)) return notModified(etag, "Accept-Encoding");
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        std::vector<HttpResponse> responses = fanOut("GET", "/shard/search/" + query, "", "", deadline);
+        std::vector<ShardPage> pages;
+        bool partial = false;
+        crow::response error;
+        if (!collectPages(responses, pages, partial, error)) return error;
+
+        // the first 15 matches over the whole catalog, like steam_server
+        auto hits = mergeShardPages(pages, 0, 15, false);
+        std::string body = "[";
+        for (size_t i = 0; i < hits.size(); i++) {
+            if (i) body += ',';
+            body.append(hits[i]->item);
+        }
+        body += ']';
+
+        auto response = sendBody(req, std::move(body), "application/json; charset=utf-8", "Accept-Encoding");
+        addCacheHeaders(response, partial, pageKey);
+        return response;
+    });
+
+    CROW_ROUTE(app, "/recommend/global/<int>")
+    ([&](const crow::request& req, int id) { return recommend(req, "global", id); });
+
+    CROW_ROUTE(app, "/recommend/seeds")
+    ([&]() { return notSharded(); });
+
+    CROW_ROUTE(app, "/recommend/multi/<int>")
+    ([&](int) { return notSharded(); });
+
+    CROW_ROUTE(app, "/recommend/tree/<int>")
+    ([&](int) { return notSharded(); });
+
+    CROW_ROUTE(app, "/recommend/<string>/<int>")
+    ([&](const crow::request& req, std::string type, int id) { return recommend(req, type, id); });
+
+    // Requests and failed requests per shard
+    CROW_ROUTE(app, "/debug/shards")
+    ([&]() {
+        std::string body = "[";
+        for (size_t i = 0; i < shards.size(); i++) {
+            if (i) body += ',';
+            body += "{\"failures\":" + std::to_string(shards[i]->failures.load()) + ",\"requests\":" +
+                    std::to_string(shards[i]->requests.load()) + ",\"shard\":\"" + shards[i]->host + ":" +
+                    std::to_string(shards[i]->port) + "\"}";
+        }
+        body += ']';
+
+        auto response = crow::response(body);
+        response.add_header("Content-Type", "application/json; charset=utf-8");
+        response.add_header("Cache-Control", "no-store");
+        return response;
+    });
+
+    CROW_CATCHALL_ROUTE(app)
+    ([&](const crow::request& req, crow::response& res) {
+        res.add_header("Access-Control-Allow-Origin", "*");
+        res.add_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+        res.add_header("Access-Control-Allow-Headers", "Content-Type, X-Request-Timeout-Ms");
+        res.code = req.method == crow::HTTPMethod::Options ? 200 : 404;
+        res.end();
+    });
+
+    const char* port = std::getenv("PORT");
+    uint16_t portNum = port ? (uint16_t)std::stoi(port) : 8080;
+
+    std::cout << "Coordinator online on port " << portNum << " over " << shards.size() << " shards" << std::endl;
+    app.port(portNum).concurrency(threads).loglevel(crow::LogLevel::Warning).run();
+    return 0;
+}
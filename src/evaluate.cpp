@@ -0,0 +1,169 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <functional>
+#include <unordered_set>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include "Catalog.h"
+
+// Ranking quality of approximate scoring paths against the exact brute-force scan:
+//
+//   steam_eval [--data <dir>] [--samples 200] [--k 10,50,90] [--budget-us 2000] [--seed 1]
+//
+// For a seeded sample of target games every approximation's ranked list is compared with the
+// exact one and recall@K, NDCG@K (exact scores as graded relevance) and the mean absolute error
+// of the approximate scores are reported next to the latency of both paths.
+
+// An approximate ranking and the exact ranking it stands in for
+struct Approximation {
+    std::string name;
+    std::function<ScoredList(int)> exact;
+    std::function<ScoredList(int)> approx;
+    std::function<float(int, int)> exactScore;  // exact score of candidate b for target a
+};
+
+struct Measurement {
+    std::vector<double> recall, ndcg, scoreError;
+};
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(p * values.size());
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+double mean(const std::vector<double>& values) {
+    if (values.empty()) return 0;
+    double sum = 0;
+    for (double v : values) sum += v;
+    return sum / values.size();
+}
+
+template <typename Fn>
+ScoredList timed(Fn&& fn, int target, std::vector<double>& ms) {
+    auto start = std::chrono::steady_clock::now();
+    ScoredList ranked = fn(target);
+    ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return ranked;
+}
+
+int main(int argc, char** argv) {
+    std::string dataDir;
+    size_t samples = 200;
+    std::vector<size_t> ks = {10, 50, 90};
+    int budgetUs = 2000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--data") dataDir = argv[i + 1];
+        else if (flag == "--samples") samples = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--budget-us") budgetUs = std::atoi(argv[i + 1]);
+        else if (flag == "--seed") seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--k") {
+            ks.clear();
+            std::stringstream list(argv[i + 1]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                if (std::atoi(item.c_str()) > 0) ks.push_back((size_t)std::atoi(item.c_str()));
+            }
+        } else {
+            std::cerr << "Unknown flag " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    loadData(dataDir);
+    if (globalGames.empty() || ks.empty()) {
+        std::cerr << "ERROR: No games loaded, pass --data <dir>" << std::endl;
+        return 1;
+    }
+    buildIndexes();
+
+    ScanFilter noFilter;
+    auto globalScore = [](int a, int b) { return getGlobalScore(globalGames[a], globalGames[b]); };
+    auto jaccardScore = [](int a, int b) { return getJaccard(globalGames[a], globalGames[b]); };
+
+    // each path is scanned with the threshold its route uses
+    std::vector<Approximation> approximations = {
+        {"minhash~jaccard",
+         [&](int t) { return rankByScore(scanCatalog(noFilter, {t}, 0.1f, [&](const CompactGame& g) { return getJaccard(globalGames[t], g); })); },
+         [&](int t) { return rankByScore(scanCatalog(noFilter, {t}, 0.1f, [&](const CompactGame& g) { return getMinHash(globalGames[t], g); })); },
+         jaccardScore},
+        {"global@" + std::to_string(budgetUs) + "us",
+         [&](int t) { return rankByScore(scanCatalog(noFilter, {t}, 0.15f, [&](const CompactGame& g) { return getGlobalScore(globalGames[t], g); })); },
+         [&](int t) {
+             ScanDeadline deadline{std::chrono::steady_clock::now() + std::chrono::microseconds(budgetUs)};
+             DeadlineScope scope(deadline);
+             return rankByScore(scanCatalog(noFilter, {t}, 0.15f, [&](const CompactGame& g) { return getGlobalScore(globalGames[t], g); }));
+         },
+         globalScore},
+    };
+
+    std::mt19937_64 rng(seed);
+    std::vector<int> targets(samples);
+    for (auto& t : targets) t = (int)(rng() % globalGames.size());
+
+    std::cout << std::left << std::setw(20) << "approximation" << std::right << std::setw(6) << "K" << std::setw(10)
+              << "recall" << std::setw(10) << "ndcg" << std::setw(12) << "score MAE" << std::setw(12) << "exact p50"
+              << std::setw(12) << "exact p99" << std::setw(12) << "approx p50" << std::setw(12) << "approx p99"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for (const auto& a : approximations) {
+        std::vector<Measurement> byK(ks.size());
+        std::vector<double> exactMs, approxMs;
+
+        for (int t : targets) {
+            ScoredList exact = timed(a.exact, t, exactMs);
+            ScoredList approx = timed(a.approx, t, approxMs);
+
+            for (size_t ki = 0; ki < ks.size(); ki++) {
+                size_t k = ks[ki];
+                size_t relevant = std::min(k, exact.size());
+                if (relevant == 0) continue;
+
+                std::unordered_set<int> exactTop;
+                double idcg = 0;
+                for (size_t i = 0; i < relevant; i++) {
+                    exactTop.insert(exact[i].second);
+                    idcg += exact[i].first / std::log2(i + 2.0);
+                }
+
+                size_t hits = 0;
+                double dcg = 0, error = 0;
+                size_t returned = std::min(k, approx.size());
+                for (size_t i = 0; i < returned; i++) {
+                    int candidate = approx[i].second;
+                    float truth = a.exactScore(t, candidate);
+                    hits += exactTop.count(candidate);
+                    dcg += truth / std::log2(i + 2.0);
+                    error += std::fabs(approx[i].first - truth);
+                }
+
+                byK[ki].recall.push_back((double)hits / relevant);
+                if (idcg > 0) byK[ki].ndcg.push_back(dcg / idcg);
+                if (returned > 0) byK[ki].scoreError.push_back(error / returned);
+            }
+        }
+
+        for (size_t ki = 0; ki < ks.size(); ki++) {
+            const Measurement& m = byK[ki];
+            double exactP50 = percentile(exactMs, 0.5), approxP50 = percentile(approxMs, 0.5);
+            std::cout << std::left << std::setw(20) << a.name << std::right << std::setw(6) << ks[ki] << std::fixed
+                      << std::setprecision(4) << std::setw(10) << mean(m.recall) << std::setw(10) << mean(m.ndcg)
+                      << std::setw(12) << mean(m.scoreError) << std::setprecision(3) << std::setw(12) << exactP50
+                      << std::setw(12) << percentile(exactMs, 0.99) << std::setw(12) << approxP50 << std::setw(12)
+                      << percentile(approxMs, 0.99) << std::setprecision(2) << std::setw(9)
+                      << (approxP50 > 0 ? exactP50 / approxP50 : 0.0) << "x" << std::endl;
+        }
+    }
+
+    std::cout << "(" << targets.size() << " targets, latencies in ms)" << std::endl;
+    return 0;
+}
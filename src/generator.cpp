@@ -0,0 +1,279 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include "CompactGame.h"
+#include "TagVotes.h"
+#include "Signatures.h"
+
+// Writes a synthetic catalog in the converter's format (games_1..K.bin, strings.bin, tagvotes.bin)
+// at any size, for load time, memory and scan latency scaling tests:
+//
+//   data_generator --games <count> [--out <dir>] [--seed <n>] [--shard-size <games>]
+//                  [--tags <tags.txt>] [--reference <dir>]
+//
+// Tag popularity and tags per game are taken from the reference catalog's tagvotes.bin when there
+// is one, otherwise tags.txt only gives the vocabulary and popularity falls off Zipf-like over a
+// seeded ranking. Signatures come from TagSignatures, so generated games score like real ones.
+
+std::mt19937_64 rng;
+
+double uniform() {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+
+double gammaSample(double shape) {
+    return std::gamma_distribution<double>(shape, 1.0)(rng);
+}
+
+// Strings are appended to strings.bin as they are made, only repeated ones are interned
+class PoolWriter {
+public:
+    explicit PoolWriter(const std::string& path) : out(path, std::ios::binary) {
+        out.put('\0');
+    }
+
+    uint32_t add(const std::string& str) {
+        if (str.empty()) return 0;
+        uint64_t offset = size;
+        out.write(str.data(), str.size());
+        out.put('\0');
+        size += str.size() + 1;
+        if (size > UINT32_MAX) {
+            std::cerr << "ERROR: string pool passed 4 GB, use fewer games" << std::endl;
+            std::exit(1);
+        }
+        return (uint32_t)offset;
+    }
+
+    uint32_t intern(const std::string& str) {
+        auto it = cache.find(str);
+        if (it != cache.end()) return it->second;
+        uint32_t offset = add(str);
+        cache[str] = offset;
+        return offset;
+    }
+
+    uint64_t bytes() const { return size; }
+
+private:
+    std::ofstream out;
+    uint64_t size = 1;
+    std::unordered_map<std::string, uint32_t> cache;
+};
+
+// Tag document frequencies and the tags-per-game histogram of an existing tagvotes.bin
+bool loadReference(const std::string& path, size_t tagCount, std::vector<double>& tagWeights,
+                   std::vector<double>& tagsPerGame) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    uint32_t gameCount = 0;
+    in.read((char*)&gameCount, sizeof(gameCount));
+    std::vector<uint32_t> offsets(gameCount + 1);
+    in.read((char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    std::vector<TagWeight> entries(offsets.back());
+    in.read((char*)entries.data(), entries.size() * sizeof(TagWeight));
+    if (!in || gameCount == 0) return false;
+
+    tagWeights.assign(tagCount, 0.0);
+    tagsPerGame.assign(21, 0.0);
+    for (const auto& e : entries) {
+        if (e.tag < tagCount) tagWeights[e.tag] += 1.0;
+    }
+    for (uint32_t i = 0; i < gameCount; i++) {
+        tagsPerGame[std::min<uint32_t>(20, offsets[i + 1] - offsets[i])] += 1.0;
+    }
+
+    // every tag stays possible, however rare
+    for (auto& w : tagWeights) w += 0.5;
+    std::cout << "Tag distribution taken from " << gameCount << " games in " << path << std::endl;
+    return true;
+}
+
+// Steam style app ids: multiples of 10 with gaps of up to MAX_ID_STEP
+constexpr uint32_t FIRST_ID = 10;
+constexpr uint32_t MAX_ID_STEP = 80;
+
+int main(int argc, char** argv) {
+    size_t gameCount = 0;
+    std::string outDir = "data/synthetic";
+    std::string tagsPath = "data/tags.txt";
+    std::string referenceDir = "data";
+    uint64_t seed = 42;
+    size_t shardSize = 55000;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--games") gameCount = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--out") outDir = argv[i + 1];
+        else if (flag == "--seed") seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--shard-size") shardSize = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--tags") tagsPath = argv[i + 1];
+        else if (flag == "--reference") referenceDir = argv[i + 1];
+        else {
+            std::cerr << "Unknown flag " << flag << std::endl;
+            return 1;
+        }
+    }
+    // ids advance by up to MAX_ID_STEP per game and must not wrap around uint32
+    if (gameCount == 0 || shardSize == 0 || gameCount > (UINT32_MAX - FIRST_ID) / MAX_ID_STEP) {
+        std::cerr << "Usage: data_generator --games <count> [--out <dir>] [--seed <n>] [--shard-size <games>]"
+                  << " [--tags <tags.txt>] [--reference <dir>]" << std::endl;
+        return 1;
+    }
+
+    TagSignatures signatures;
+    if (!signatures.load(tagsPath) || signatures.tagNames.empty()) {
+        std::cerr << "ERROR: Could not read tags from " << tagsPath << "!" << std::endl;
+        return 1;
+    }
+    size_t tagCount = signatures.tagNames.size();
+    rng.seed(seed);
+
+    std::vector<double> tagWeights, tagsPerGame;
+    if (!loadReference(referenceDir + "/tagvotes.bin", tagCount, tagWeights, tagsPerGame)) {
+        std::vector<size_t> rank(tagCount);
+        for (size_t i = 0; i < tagCount; i++) rank[i] = i;
+        std::shuffle(rank.begin(), rank.end(), rng);
+        tagWeights.assign(tagCount, 0.0);
+        for (size_t i = 0; i < tagCount; i++) tagWeights[rank[i]] = 1.0 / std::pow((double)i + 1.0, 1.07);
+        // Steam shows up to 20 user tags, most games have 10 or more
+        tagsPerGame = {0.5, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 7, 7, 6, 6, 6, 6, 6, 30};
+        std::cout << "No reference tagvotes.bin, using a Zipf tag distribution" << std::endl;
+    }
+
+    // Games cluster into themes that favour their own few dozen tags, which gives the similarity
+    // scans the clumpy neighbourhoods real genres produce instead of uniform noise
+    const int themeCount = 64;
+    std::vector<std::discrete_distribution<int>> themes;
+    for (int t = 0; t < themeCount; t++) {
+        std::vector<double> weights = tagWeights;
+        for (int k = 0; k < 30; k++) weights[rng() % tagCount] *= 25.0;
+        themes.emplace_back(weights.begin(), weights.end());
+    }
+    std::discrete_distribution<int> popular(tagWeights.begin(), tagWeights.end());
+    std::discrete_distribution<int> tagsPerGameDist(tagsPerGame.begin(), tagsPerGame.end());
+
+    static const char* firstWords[] = {"Dark", "Star", "Lost", "Super", "Tiny", "Iron", "Neon", "Pixel", "Hollow",
+                                       "Crimson", "Eternal", "Silent", "Wild", "Cosmic", "Little", "Last", "Broken",
+                                       "Ancient", "Hyper", "Shadow", "Golden", "Frozen", "Mystic", "Rogue"};
+    static const char* secondWords[] = {"Kingdom", "Odyssey", "Tactics", "Farm", "Legends", "Dungeon", "Racer",
+                                        "Colony", "Frontier", "Saga", "Arena", "Quest", "Empire", "Survivors",
+                                        "Simulator", "Chronicles", "Drift", "Protocol", "Harvest", "Knight",
+                                        "Station", "Tales", "Heist", "Garden"};
+    static const char* suffixes[] = {"", "", "", "", " II", " III", ": Remastered", " Deluxe", " Online",
+                                     ": Prologue", " VR", " 2", " Zero", ": Definitive Edition"};
+    static const char* genreNames[] = {"Action", "Adventure", "Casual", "Indie", "RPG", "Simulation", "Strategy",
+                                       "Racing", "Sports", "Massively Multiplayer", "Early Access", "Free to Play"};
+    static const double pricePoints[] = {0.99, 1.99, 2.99, 4.99, 6.99, 9.99, 12.99, 14.99, 19.99, 24.99, 29.99,
+                                         39.99, 49.99, 59.99, 69.99};
+    std::discrete_distribution<int> priceDist({4, 6, 5, 12, 6, 14, 5, 10, 10, 6, 5, 4, 3, 3, 1});
+
+    size_t developerCount = std::max<size_t>(100, gameCount / 4);
+    size_t publisherCount = std::max<size_t>(50, gameCount / 8);
+
+    std::filesystem::create_directories(outDir);
+    PoolWriter pool(outDir + "/strings.bin");
+
+    // tagvotes.bin gets its header once every offset is known
+    std::ofstream outVotes(outDir + "/tagvotes.bin", std::ios::binary);
+    std::vector<uint32_t> voteOffsets = {0};
+    voteOffsets.reserve(gameCount + 1);
+    outVotes.seekp((std::streamoff)(sizeof(uint32_t) * (gameCount + 2)));
+
+    std::ofstream outGames;
+    int shard = 0;
+    uint32_t id = FIRST_ID;
+    uint64_t voteTotal = 0;
+
+    std::vector<std::pair<int, int>> votes;
+    std::vector<TagWeight> entries;
+    for (size_t i = 0; i < gameCount; i++) {
+        if (i % shardSize == 0) {
+            if (outGames.is_open()) outGames.close();
+            outGames.open(outDir + "/games_" + std::to_string(++shard) + ".bin", std::ios::binary);
+        }
+
+        CompactGame cg = {};
+        id += 10 * (1 + (uint32_t)(rng() % (MAX_ID_STEP / 10)));
+        cg.id = id;
+
+        // review counts are heavy tailed, the positive share sits around 80% like on Steam
+        double reviews = std::floor(std::exp(std::normal_distribution<double>(3.0, 2.0)(rng)));
+        if (uniform() < 0.1 || reviews < 1) {
+            cg.reviewScore = -1.0f;
+        } else {
+            double a = gammaSample(6.0), b = gammaSample(1.6);
+            double positive = std::round(reviews * a / (a + b));
+            cg.reviewScore = (float)(positive / reviews);
+        }
+        cg.price = uniform() < 0.12 ? 0.0f : (float)pricePoints[priceDist(rng)];
+        cg.metacriticScore = uniform() < 0.04
+                ? (int16_t)std::clamp(std::lround(std::normal_distribution<double>(72.0, 9.0)(rng)), 20L, 98L)
+                : -1; // missing, as the converter writes it
+
+        std::string name = std::string(firstWords[rng() % std::size(firstWords)]) + " " +
+                           secondWords[rng() % std::size(secondWords)] + suffixes[rng() % std::size(suffixes)];
+        if (uniform() < 0.3) name += " " + std::to_string(1 + rng() % 999);
+        cg.nameOffset = pool.add(name);
+        cg.imageUrlOffset = pool.add("https://shared.akamai.steamstatic.com/store_item_assets/steam/apps/" +
+                                     std::to_string(id) + "/header.jpg");
+
+        // a handful of studios make many games, most make one or two
+        size_t developer = (size_t)(developerCount * std::pow(uniform(), 2.5));
+        cg.developerOffset = pool.intern("Studio " + std::to_string(developer));
+        cg.publisherOffset = uniform() < 0.6 ? pool.intern("Studio " + std::to_string(developer))
+                                             : pool.intern("Publisher " + std::to_string((size_t)(publisherCount * std::pow(uniform(), 3.0))));
+
+        std::string genres = genreNames[rng() % std::size(genreNames)];
+        if (uniform() < 0.6) genres += std::string(",") + genreNames[rng() % std::size(genreNames)];
+        cg.genresOffset = pool.intern(genres);
+
+        // tags in descending vote order, half from the game's theme and half from overall popularity
+        int tagTarget = std::min<int>(tagsPerGameDist(rng), (int)tagCount);
+        auto& theme = themes[rng() % themeCount];
+        double topVotes = std::max(1.0, std::exp(std::normal_distribution<double>(4.0, 1.5)(rng)));
+        votes.clear();
+        for (int attempts = 0; (int)votes.size() < tagTarget && attempts < tagTarget * 20; attempts++) {
+            int tag = uniform() < 0.5 ? theme(rng) : popular(rng);
+            bool seen = false;
+            for (auto& v : votes) seen |= v.first == tag;
+            if (seen) continue;
+            double share = std::pow((double)votes.size() + 1.0, -0.7) * (0.8 + 0.4 * uniform());
+            votes.push_back({tag, std::max(1, (int)std::lround(topVotes * share))});
+        }
+
+        signatures.fill(cg, votes);
+        entries.clear();
+        appendTagWeights(votes, entries);
+        outVotes.write((const char*)entries.data(), entries.size() * sizeof(TagWeight));
+        voteTotal += entries.size();
+        if (voteTotal > UINT32_MAX) {
+            std::cerr << "ERROR: too many tag votes for tagvotes.bin offsets" << std::endl;
+            return 1;
+        }
+        voteOffsets.push_back((uint32_t)voteTotal);
+
+        outGames.write((const char*)&cg, sizeof(CompactGame));
+
+        if ((i + 1) % 1000000 == 0) std::cout << "Generated " << (i + 1) << " games" << std::endl;
+    }
+    outGames.close();
+
+    uint32_t count = (uint32_t)gameCount;
+    outVotes.seekp(0);
+    outVotes.write((const char*)&count, sizeof(count));
+    outVotes.write((const char*)voteOffsets.data(), voteOffsets.size() * sizeof(uint32_t));
+    outVotes.close();
+
+    std::cout << "Wrote " << gameCount << " games in " << shard << " shards, " << pool.bytes()
+              << " string pool bytes and " << voteTotal << " tag votes to " << outDir << std::endl;
+    return 0;
+}
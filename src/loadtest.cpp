@@ -0,0 +1,324 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include "CompactGame.h"
+#include "HttpClient.h"
+
+// Closed-loop load generator for steam_server. Every connection is a thread with its own
+// keep-alive socket that sends its next request as soon as the previous one answers:
+//
+//   steam_loadtest [--host 127.0.0.1] [--port 8080] [--connections 32] [--duration 30] [--warmup 5]
+//                  [--workload <file>] [--data <dir>] [--zipf 1.0] [--search-share 0.5] [--gzip 1]
+//                  [--timeout-ms 10000]
+//
+// With --workload the file's request paths (one per line, # for comments) are replayed in a loop,
+// spread over the connections. Otherwise a synthetic mix is generated from the catalog in --data:
+// search-as-you-type bursts (every prefix of a game's name, back to back) and recommend calls whose
+// target ids follow a Zipf distribution over a seeded popularity ranking.
+// Throughput and p50/p99/p999 latency are reported per route once the run is over. A request is
+// sent once: a timeout or a dropped connection counts as a failed request, not as a retry.
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 32;
+    double duration = 30;
+    double warmup = 5;
+    std::string workload;
+    std::string dataDir = "data";
+    double zipf = 1.0;
+    double searchShare = 0.5;
+    bool gzip = true;
+    int timeoutMs = 10000;
+};
+
+struct RouteStats {
+    std::vector<uint32_t> latencyUs;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    std::map<int, uint64_t> codes;
+};
+
+using StatsByRoute = std::map<std::string, RouteStats>;
+
+// ids and lowercase names, everything the synthetic mix needs from the catalog
+struct CatalogSample {
+    std::vector<uint32_t> ids;
+    std::vector<std::string> names;
+};
+
+bool loadCatalogSample(const std::string& dir, CatalogSample& sample) {
+    std::ifstream sFile(dir + "/strings.bin", std::ios::binary | std::ios::ate);
+    if (!sFile.is_open()) return false;
+    std::vector<char> pool((size_t)sFile.tellg());
+    sFile.seekg(0);
+    sFile.read(pool.data(), pool.size());
+
+    CompactGame g;
+    for (int shard = 1;; shard++) {
+        std::ifstream gFile(dir + "/games_" + std::to_string(shard) + ".bin", std::ios::binary);
+        if (!gFile.is_open()) break;
+        while (gFile.read((char*)&g, sizeof(g))) {
+            std::string name = g.nameOffset < pool.size() ? &pool[g.nameOffset] : "";
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            sample.ids.push_back(g.id);
+            sample.names.push_back(std::move(name));
+        }
+    }
+    return !sample.ids.empty();
+}
+
+std::string urlEncode(const std::string& s) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : s) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += (char)c;
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+// "/recommend/jaccard/570?limit=20" -> "recommend/jaccard", "/search/port" -> "search"
+std::string routeOf(const std::string& path) {
+    std::string p = path.substr(0, path.find('?'));
+    std::vector<std::string> parts;
+    size_t start = 1;
+    while (start <= p.size()) {
+        size_t end = p.find('/', start);
+        if (end == std::string::npos) end = p.size();
+        if (end > start) parts.push_back(p.substr(start, end - start));
+        start = end + 1;
+    }
+    if (parts.empty()) return "/";
+    if (parts[0] == "recommend" && parts.size() > 1) return "recommend/" + parts[1];
+    return parts[0];
+}
+
+// Zipf over ranks 0..n-1 by inverse CDF, rank r is then mapped to a game by a fixed shuffle
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s, uint64_t seed) : cdf(n), order(n) {
+        double total = 0;
+        for (size_t r = 0; r < n; r++) {
+            total += 1.0 / std::pow((double)r + 1.0, s);
+            cdf[r] = total;
+        }
+        for (auto& c : cdf) c /= total;
+        for (size_t i = 0; i < n; i++) order[i] = i;
+        std::mt19937_64 rng(seed);
+        std::shuffle(order.begin(), order.end(), rng);
+    }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t r = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        return order[std::min(r, order.size() - 1)];
+    }
+
+private:
+    std::vector<double> cdf;
+    std::vector<size_t> order;
+};
+
+// next batch of request paths for one connection, a search burst is one batch
+class SyntheticMix {
+public:
+    SyntheticMix(const CatalogSample& catalog, const ZipfSampler& zipf, double searchShare)
+        : catalog(catalog), zipf(zipf), searchShare(searchShare) {}
+
+    void next(std::mt19937_64& rng, std::vector<std::string>& batch) const {
+        batch.clear();
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        size_t game = zipf(rng);
+
+        if (unit(rng) < searchShare) {
+            const std::string& name = catalog.names[game];
+            size_t typed = std::min<size_t>(name.size(), 3 + rng() % 10);
+            for (size_t len = 1; len <= typed; len++) batch.push_back("/search/" + urlEncode(name.substr(0, len)));
+            return;
+        }
+
+        std::string id = std::to_string(catalog.ids[game]);
+        double pick = unit(rng);
+        if (pick < 0.30) batch.push_back("/recommend/global/" + id);
+        else if (pick < 0.45) batch.push_back("/recommend/jaccard/" + id);
+        else if (pick < 0.60) batch.push_back("/recommend/minhash/" + id);
+        else if (pick < 0.75) batch.push_back("/recommend/cosine/" + id);
+        else if (pick < 0.80) batch.push_back("/recommend/wjaccard/" + id);
+        else if (pick < 0.85) batch.push_back("/recommend/multi/" + id);
+        else if (pick < 0.90) batch.push_back("/recommend/tree/" + id);
+        else {
+            std::string ids = id;
+            for (int k = 0, extra = 2 + rng() % 3; k < extra; k++) ids += "," + std::to_string(catalog.ids[zipf(rng)]);
+            batch.push_back("/recommend/seeds?ids=" + ids);
+        }
+    }
+
+private:
+    const CatalogSample& catalog;
+    const ZipfSampler& zipf;
+    double searchShare;
+};
+
+double percentileMs(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--host") opt.host = value;
+        else if (flag == "--port") opt.port = std::atoi(value);
+        else if (flag == "--connections") opt.connections = std::max(1, std::atoi(value));
+        else if (flag == "--duration") opt.duration = std::atof(value);
+        else if (flag == "--warmup") opt.warmup = std::atof(value);
+        else if (flag == "--workload") opt.workload = value;
+        else if (flag == "--data") opt.dataDir = value;
+        else if (flag == "--zipf") opt.zipf = std::atof(value);
+        else if (flag == "--search-share") opt.searchShare = std::atof(value);
+        else if (flag == "--gzip") opt.gzip = std::atoi(value) != 0;
+        else if (flag == "--timeout-ms") opt.timeoutMs = std::max(1, std::atoi(value));
+        else {
+            std::cerr << "Unknown flag " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> workload;
+    CatalogSample catalog;
+    if (!opt.workload.empty()) {
+        std::ifstream in(opt.workload);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] == '/') workload.push_back(line);
+        }
+        if (workload.empty()) {
+            std::cerr << "ERROR: No request paths in " << opt.workload << std::endl;
+            return 1;
+        }
+        std::cout << "Replaying " << workload.size() << " requests from " << opt.workload << std::endl;
+    } else {
+        if (!loadCatalogSample(opt.dataDir, catalog)) {
+            std::cerr << "ERROR: Could not read games from " << opt.dataDir << ", pass --data or --workload" << std::endl;
+            return 1;
+        }
+        std::cout << "Synthetic mix over " << catalog.ids.size() << " games, zipf " << opt.zipf << std::endl;
+    }
+    ZipfSampler zipf(catalog.ids.empty() ? 1 : catalog.ids.size(), opt.zipf, 7);
+    SyntheticMix mix(catalog, zipf, opt.searchShare);
+
+    std::string headers = opt.gzip ? "Accept-Encoding: gzip\r\n" : "";
+    std::atomic<bool> recording{false}, stop{false};
+    std::vector<StatsByRoute> perThread(opt.connections);
+    std::vector<std::thread> threads;
+
+    for (int c = 0; c < opt.connections; c++) {
+        threads.emplace_back([&, c] {
+            HttpConnection conn(opt.host, opt.port, opt.timeoutMs);
+            std::mt19937_64 rng(1000 + c);
+            StatsByRoute& stats = perThread[c];
+            std::vector<std::string> batch;
+            size_t cursor = c;
+            HttpResponse response;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!workload.empty()) {
+                    batch.assign(1, workload[cursor % workload.size()]);
+                    cursor += opt.connections;
+                } else {
+                    mix.next(rng, batch);
+                }
+
+                for (const auto& path : batch) {
+                    auto start = std::chrono::steady_clock::now();
+                    bool ok = conn.get(path, response, headers);
+                    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                    if (!recording.load(std::memory_order_relaxed)) continue;
+
+                    RouteStats& route = stats[routeOf(path)];
+                    route.latencyUs.push_back((uint32_t)std::min<long long>(us, UINT32_MAX));
+                    route.codes[ok ? response.status : 0]++;
+                    if (ok) route.bytes += response.body.size();
+                    if (!ok || (response.status >= 400)) route.errors++;
+                    if (!ok) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.warmup));
+    recording = true;
+    auto measuredStart = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration));
+    recording = false;
+    double measured = std::chrono::duration<double>(std::chrono::steady_clock::now() - measuredStart).count();
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    StatsByRoute total;
+    for (auto& stats : perThread) {
+        for (auto& [name, route] : stats) {
+            RouteStats& merged = total[name];
+            merged.latencyUs.insert(merged.latencyUs.end(), route.latencyUs.begin(), route.latencyUs.end());
+            merged.errors += route.errors;
+            merged.bytes += route.bytes;
+            for (auto& [code, n] : route.codes) merged.codes[code] += n;
+        }
+    }
+
+    std::cout << "\n" << opt.connections << " connections, " << std::fixed << std::setprecision(1) << measured
+              << " s measured after " << opt.warmup << " s warmup\n\n";
+    std::cout << std::left << std::setw(22) << "route" << std::right << std::setw(10) << "requests" << std::setw(10)
+              << "req/s" << std::setw(8) << "errors" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+              << std::setw(10) << "p999 ms" << std::setw(10) << "max ms" << std::setw(10) << "MB/s" << "\n";
+
+    uint64_t allRequests = 0, allErrors = 0;
+    std::vector<uint32_t> all;
+    auto printRow = [&](const std::string& name, std::vector<uint32_t>& latency, uint64_t errors, uint64_t bytes) {
+        std::sort(latency.begin(), latency.end());
+        std::cout << std::left << std::setw(22) << name << std::right << std::setw(10) << latency.size()
+                  << std::setw(10) << std::setprecision(1) << latency.size() / measured << std::setw(8) << errors
+                  << std::setprecision(2) << std::setw(10) << percentileMs(latency, 0.50) << std::setw(10)
+                  << percentileMs(latency, 0.99) << std::setw(10) << percentileMs(latency, 0.999) << std::setw(10)
+                  << (latency.empty() ? 0.0 : latency.back() / 1000.0) << std::setw(10) << bytes / measured / 1e6 << "\n";
+    };
+
+    uint64_t allBytes = 0;
+    for (auto& [name, route] : total) {
+        printRow(name, route.latencyUs, route.errors, route.bytes);
+        allRequests += route.latencyUs.size();
+        allErrors += route.errors;
+        allBytes += route.bytes;
+        all.insert(all.end(), route.latencyUs.begin(), route.latencyUs.end());
+    }
+    printRow("total", all, allErrors, allBytes);
+
+    std::cout << "\nstatus codes:";
+    std::map<int, uint64_t> codes;
+    for (auto& [name, route] : total) {
+        for (auto& [code, n] : route.codes) codes[code] += n;
+    }
+    for (auto& [code, n] : codes) std::cout << " " << (code ? std::to_string(code) : "failed") << "=" << n;
+    std::cout << std::endl;
+    return allRequests > 0 && allErrors < allRequests ? 0 : 1;
+}
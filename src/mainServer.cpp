@@ -3,115 +3,293 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <crow.h>
 #include <nlohmann/json.hpp>
-#include "CompactGame.h"
-
-using json = nlohmann::json;
-
-std::vector<CompactGame> globalGames;
-std::vector<char> globalStringPool;
-
-float roundToTwo(float val) {
-    return std::round(val * 100.0f) / 100.0f;
+#include "Catalog.h"
+#include "ResultStore.h"
+#include "TagVotes.h"
+#include "JsonWriter.h"
+#include "MsgPackWriter.h"
+#include "Compression.h"
+#include "HttpUtil.h"
+#include "StaticFiles.h"
+#include "Admission.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "SlowLog.h"
+#include "Shard.h"
+#include "Prefork.h"
+
+// Scored lists kept for cursor pagination: 512 lists, 4M candidates (~32 MB) in total, 2 minutes each
+ResultStore resultStore(512, 4000000, std::chrono::seconds(120));
+
+// One admission gate per expensive route, all drawing on one budget of worker threads, created in
+// main once the worker count is known
+std::unique_ptr<AdmissionBudget> scanBudget;
+std::vector<std::unique_ptr<AdmissionGate>> admissionGates;
+
+// request path logging, drained to LOG_FILE (default stdout) by a background thread
+Logger globalLogger;
+
+// per-thread request counters and latency histograms, scraped from /metrics
+Metrics globalMetrics;
+
+// requests slower than SLOW_REQUEST_MS (0 disables), the last 256 are kept for /debug/slow
+SlowLog slowLog(256);
+double slowThresholdSeconds = 0.5;
+
+// built React frontend, served from memory by the catch-all route
+StaticFiles staticFiles;
+
+// gzipped response pages, so a hot page is compressed once rather than per request (64 MB)
+PageCache pageCache(4096, 64 * 1024 * 1024, std::chrono::seconds(120));
+
+bool parseFloatParam(const crow::request& req, const char* name, float& out) {
+    const char* raw = req.url_params.get(name);
+    if (!raw) return true;
+
+    char* end = nullptr;
+    float val = std::strtof(raw, &end);
+    if (end == raw || *end != '\0' || std::isnan(val)) return false;
+    out = val;
+    return true;
 }
 
-const char* getString(uint32_t offset) {
-    if (offset >= globalStringPool.size()) return "";
-    return &globalStringPool[offset];
+// reads minPrice/maxPrice/minReview/maxReview/minMetacritic/maxMetacritic, false on a malformed value
+bool parseFilter(const crow::request& req, ScanFilter& filter) {
+    bool ok = parseFloatParam(req, "minPrice", filter.minPrice) &&
+              parseFloatParam(req, "maxPrice", filter.maxPrice) &&
+              parseFloatParam(req, "minReview", filter.minReview) &&
+              parseFloatParam(req, "maxReview", filter.maxReview) &&
+              parseFloatParam(req, "minMetacritic", filter.minMetacritic) &&
+              parseFloatParam(req, "maxMetacritic", filter.maxMetacritic);
+
+    filter.active = filter.minPrice != -std::numeric_limits<float>::infinity() ||
+                    filter.maxPrice != std::numeric_limits<float>::infinity() ||
+                    filter.minReview != -std::numeric_limits<float>::infinity() ||
+                    filter.maxReview != std::numeric_limits<float>::infinity() ||
+                    filter.minMetacritic != -std::numeric_limits<float>::infinity() ||
+                    filter.maxMetacritic != std::numeric_limits<float>::infinity();
+    return ok;
 }
 
-void loadData() {
+// canonical text of the filter, part of the result store key
+std::string filterKey(const ScanFilter& filter) {
+    if (!filter.active) return "";
+    std::ostringstream key;
+    key << std::setprecision(9) << "|p" << filter.minPrice << ',' << filter.maxPrice
+        << "|r" << filter.minReview << ',' << filter.maxReview
+        << "|m" << filter.minMetacritic << ',' << filter.maxMetacritic;
+    return key.str();
+}
 
-    std::vector<std::string> possiblePaths = {"data/", "src/data/", "../src/data/"};
-    std::string foundPath = "data/";
 
-    // Determine which directory actually contains our data
-    for (const auto& p : possiblePaths) {
-        std::ifstream check(p + "games_1.bin");
-        if (check.good()) {
-            foundPath = p;
-            break;
-        }
+// most seeds one /recommend/seeds request may name, mean and max mode cost grows with each one
+constexpr size_t MAX_SEEDS = 100;
+
+// parses a comma separated id list, false on anything that is not a plain decimal uint32
+bool parseIdList(const std::string& raw, std::vector<uint32_t>& ids) {
+    std::stringstream ss(raw);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        // strtoull would take a sign or leading blanks and wrap "-1" into a valid looking id
+        if (!std::isdigit((unsigned char)item[0])) return false;
+        errno = 0;
+        char* end = nullptr;
+        unsigned long long val = std::strtoull(item.c_str(), &end, 10);
+        if (*end != '\0' || errno == ERANGE || val > std::numeric_limits<uint32_t>::max()) return false;
+        ids.push_back((uint32_t)val);
     }
+    return true;
+}
 
-    std::vector<std::string> gameFiles = {foundPath + "games_1.bin", foundPath + "games_2.bin"};
-    globalGames.clear();
 
-    for (const auto& path : gameFiles) {
-        std::ifstream gFile(path, std::ios::binary | std::ios::ate);
+// reads ?fields= (or the ?v=2 lean default), false on an unknown field name
+bool parseFields(const crow::request& req, uint32_t& mask) {
+    const char* version = req.url_params.get("v");
+    mask = (version && std::strcmp(version, "2") == 0) ? LEAN_FIELDS : ALL_FIELDS;
+
+    const char* rawFields = req.url_params.get("fields");
+    if (!rawFields) return true;
+
+    static const std::unordered_map<std::string, uint32_t> names = {
+        {"algorithm", FIELD_ALGORITHM}, {"id", FIELD_ID}, {"imageURL", FIELD_IMAGE_URL},
+        {"minHash", FIELD_MIN_HASH}, {"name", FIELD_NAME}, {"price", FIELD_PRICE},
+        {"score", FIELD_SCORE}, {"tagBits", FIELD_TAG_BITS}
+    };
+
+    mask = 0;
+    std::stringstream ss(rawFields);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        auto it = names.find(item);
+        if (it == names.end()) return false;
+        mask |= it->second;
+    }
+    return true;
+}
 
-        if (!gFile.is_open()) {
-            std::cerr << "ERROR: Could not find " << path << "!" << std::endl;
-            continue;
-        }
+crow::response sendBody(std::string body, const char* contentType, bool gzipped) {
+    auto response = crow::response(std::move(body));
+    response.add_header("Access-Control-Allow-Origin", "*");
+    response.add_header("Access-Control-Expose-Headers", "X-Next-Cursor, X-Partial-Results");
+    response.add_header("Content-Type", contentType);
+    response.add_header("Vary", "Accept, Accept-Encoding");
+    if (gzipped) response.add_header("Content-Encoding", "gzip");
+    return response;
+}
 
-        std::streamsize gSize = gFile.tellg();
-        gFile.seekg(0, std::ios::beg);
+// Bodies of the /shard routes, tagged with the shard's dataset version so the coordinator can
+// build validators for the whole catalog
+crow::response shardResponse(const std::string& body) {
+    char version[24];
+    std::snprintf(version, sizeof(version), "%016llx", (unsigned long long)globalDatasetVersion);
+    auto response = crow::response(body);
+    response.add_header("Content-Type", "application/octet-stream");
+    response.add_header("X-Dataset-Version", version);
+    return response;
+}
 
-        size_t numGamesInFile = gSize / sizeof(CompactGame);
-        size_t currentSize = globalGames.size();
+crow::response overloaded() {
+    crow::response response(503, "Server busy, retry shortly");
+    response.add_header("Access-Control-Allow-Origin", "*");
+    response.add_header("Retry-After", "1");
+    response.add_header("Cache-Control", "no-store");
+    return response;
+}
 
-        globalGames.resize(currentSize + numGamesInFile);
-        gFile.read((char*)&globalGames[currentSize], gSize);
-        gFile.close();
+// Budget for a request: X-Request-Timeout-Ms when the client sends one, else REQUEST_TIMEOUT_MS
+int defaultTimeoutMs = 2000;
 
-        std::cout << "Loaded " << numGamesInFile << " games from " << path << std::endl;
+std::chrono::steady_clock::time_point requestDeadline(const crow::request& req) {
+    int timeoutMs = defaultTimeoutMs;
+    const std::string& header = req.get_header_value("X-Request-Timeout-Ms");
+    if (!header.empty()) {
+        int requested = std::atoi(header.c_str());
+        if (requested > 0) timeoutMs = std::min(requested, defaultTimeoutMs);
     }
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+}
 
-    std::string stringsPath = foundPath + "strings.bin";
-    std::ifstream sFile(stringsPath, std::ios::binary | std::ios::ate);
+// Serves one page of a recommend route. The ranked list is kept in resultStore under key so later
+// pages (?cursor=...) are sliced from it, if it was evicted or expired the list is recomputed.
+// A full scan is only started with a slot from the route's gate, cached pages and stored lists
+// are served without one. A scan that runs out of time returns what it scored so far, marked with
+// X-Partial-Results and never stored or cached.
+crow::response servePage(const crow::request& req, const std::string& key, AdmissionGate& gate,
+                         const std::function<ScoredList()>& compute, const char* algorithm) {
+    ScanDeadline deadline{requestDeadline(req)};
+
+    size_t limit = 90;
+    if (const char* rawLimit = req.url_params.get("limit")) {
+        char* end = nullptr;
+        long val = std::strtol(rawLimit, &end, 10);
+        if (end == rawLimit || *end != '\0' || val < 1 || val > 500) return crow::response(400, "Invalid limit");
+        limit = (size_t)val;
+    }
+
+    uint32_t fields;
+    if (!parseFields(req, fields)) return crow::response(400, "Unknown field");
 
-    if (!sFile.is_open()) {
-        std::cerr << "ERROR: Could not find " << stringsPath << "!" << std::endl;
-        return;
+    size_t offset = 0;
+    if (const char* cursor = req.url_params.get("cursor")) {
+        if (!decodeCursor(key, cursor, offset)) return crow::response(400, "Invalid cursor");
     }
 
-    std::streamsize sSize = sFile.tellg();
-    sFile.seekg(0, std::ios::beg);
-    globalStringPool.resize(sSize);
-    sFile.read(globalStringPool.data(), sSize);
-    sFile.close();
+    bool msgpack = wantsMsgPack(req);
+    bool gzip = acceptsGzip(req.get_header_value("Accept-Encoding"));
+    const char* contentType = msgpack ? "application/msgpack" : "application/json; charset=utf-8";
+
+    // hot pages come straight out of the page cache already compressed
+    std::string pageKey = key + "#" + std::to_string(offset) + "," + std::to_string(limit) + "," +
+                          std::to_string(fields) + (msgpack ? ",msgpack" : ",json");
 
-    std::cout << "Successfully loaded total of " << globalGames.size() << " games into RAM." << std::endl;
-    std::cout << "Successfully loaded " << sSize << " bytes into String Pool." << std::endl;
+    // revalidation is answered before any cache lookup or scoring
+    std::string etag = makeETag(globalDatasetVersion, pageKey + (gzip ? ",gzip" : ""));
+    if (etagMatches(req, etag)) return notModified(etag, "Accept, Accept-Encoding");
 
-    std::cout << "--- Data Verification (First 5 Games) ---" << std::endl;
-    for (int i = 0; i < std::min((int)globalGames.size(), 5); i++) {
-        const char* name = getString(globalGames[i].nameOffset);
-        std::cout << "Index " << i << " | ID: " << globalGames[i].id
-                  << " | Name: [" << (name ? name : "NULL") << "]" << std::endl;
+    if (gzip) {
+        std::shared_ptr<const CachedPage> page;
+        {
+            StageTimer timer(Stage::LOOKUP);
+            page = pageCache.get(pageKey);
+        }
+        globalMetrics.count(page ? Counter::PAGE_CACHE_HIT : Counter::PAGE_CACHE_MISS);
+        if (page) {
+            auto response = sendBody(page->body, contentType, true);
+            if (!page->nextCursor.empty()) response.add_header("X-Next-Cursor", page->nextCursor);
+            addValidators(response, etag);
+            return response;
+        }
     }
-    std::cout << "-----------------------------------------" << std::endl;
-}
 
-// Jaccard's Tag Similarity
-float getJaccard(const CompactGame& a, const CompactGame& b) {
-    int intersect = 0, unionSize = 0;
-    for (int i = 0; i < 8; i++) {
-        intersect += __builtin_popcount(a.tagBits[i] & b.tagBits[i]);
-        unionSize += __builtin_popcount(a.tagBits[i] | b.tagBits[i]);
+    std::shared_ptr<const ScoredList> results;
+    {
+        StageTimer timer(Stage::LOOKUP);
+        results = resultStore.get(key);
     }
-    return unionSize == 0 ? 0 : (float)intersect / unionSize;
-}
+    globalMetrics.count(results ? Counter::RESULT_STORE_HIT : Counter::RESULT_STORE_MISS);
+    if (!results) {
+        AdmissionTicket ticket(gate);
+        if (!ticket) return overloaded();
+
+        // an identical request may have filled the store while this one was queued
+        results = resultStore.get(key);
+        if (!results) {
+            DeadlineScope scope(deadline);
+            results = std::make_shared<const ScoredList>(compute());
+            if (!deadline.expired) resultStore.put(key, results);
+        }
+    }
+    if (deadline.expired) globalMetrics.count(Counter::PARTIAL_RESULTS);
+    currentTrace.results = offset < results->size() ? std::min(limit, results->size() - offset) : 0;
+
+    std::string& body = responseBuffer();
+    {
+        StageTimer timer(Stage::SERIALIZE);
+        if (msgpack) {
+            renderResultsMsgPack(body, *results, offset, limit, algorithm, fields);
+        } else {
+            renderResults(body, *results, offset, limit, algorithm, fields);
+        }
+    }
+    std::string nextCursor = offset + limit < results->size() ? encodeCursor(key, offset + limit) : "";
 
-// MinHash
-float getMinHash(const CompactGame& a, const CompactGame& b) {
-    int matches = 0;
-    for (int i = 0; i < 150; i++) {
-        if (a.minHashSignature[i] == b.minHashSignature[i]) matches++;
+    crow::response response;
+    std::string compressed;
+    if (gzip && body.size() >= COMPRESS_MIN_BYTES) {
+        StageTimer timer(Stage::COMPRESS);
+        compressed = gzipCompress(body);
     }
-    return (float)matches / 150.0f;
-}
+    if (!compressed.empty()) {
+        if (!deadline.expired) pageCache.put(pageKey, std::make_shared<const CachedPage>(CachedPage{compressed, nextCursor}));
+        response = sendBody(std::move(compressed), contentType, true);
+    } else {
+        response = sendBody(body, contentType, false);
+    }
+    if (!nextCursor.empty()) response.add_header("X-Next-Cursor", nextCursor);
 
-// Weighted Cosine
-float getCosine(const CompactGame& a, const CompactGame& b) {
-    float dot = 0;
-    for (int i = 0; i < 128; i++) dot += a.cosineSignature[i] * b.cosineSignature[i];
-    return dot;
+    if (deadline.expired) {
+        response.add_header("X-Partial-Results", "true");
+        response.add_header("Cache-Control", "no-store");
+    } else {
+        addValidators(response, etag);
+    }
+    return response;
 }
 
-
 std::string urlDecode(std::string str) {
     std::string res;
     for (size_t i = 0; i < str.length(); ++i) {
@@ -127,145 +305,657 @@ std::string urlDecode(std::string str) {
     return res;
 }
 
+// Server-Timing goes out on every response with SERVER_TIMING=1, otherwise only when the request
+// carries X-Server-Timing: 1
+bool serverTimingAlways = false;
+
+// "lookup;dur=0.012, scan;dur=3.402, ..., total;dur=3.9" in milliseconds, stages that did not run are left out
+std::string serverTiming(const RequestTrace& trace, double totalSeconds) {
+    std::string header;
+    char entry[64];
+    for (int st = 0; st < (int)Stage::COUNT; st++) {
+        if (trace.stageSeconds[st] <= 0) continue;
+        std::snprintf(entry, sizeof(entry), "%s;dur=%.3f, ", stageName((Stage)st), trace.stageSeconds[st] * 1e3);
+        header += entry;
+    }
+    std::snprintf(entry, sizeof(entry), "total;dur=%.3f", totalSeconds * 1e3);
+    return header + entry;
+}
+
+void recordSlow(const crow::request& req, const crow::response& res, double seconds) {
+    SlowRequest slow;
+    slow.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    slow.series = currentTrace.series;
+    slow.code = res.code;
+    slow.appId = currentTrace.appId;
+    slow.url = req.raw_url;
+    slow.seconds = seconds;
+    slow.candidates = currentTrace.candidates;
+    slow.results = currentTrace.results;
+    std::copy(std::begin(currentTrace.stageSeconds), std::end(currentTrace.stageSeconds), slow.stageSeconds);
+
+    if (globalLogger.enabled(LogLevel::WARNING)) {
+        globalLogger.log(LogLevel::WARNING, "slow_request", slow.url + " " + serverTiming(currentTrace, seconds));
+    }
+    slowLog.record(std::move(slow));
+}
+
+// Times every request and files it under the series its handler picked in currentTrace
+struct RequestMetrics {
+    struct context {};
+
+    void before_handle(crow::request&, crow::response&, context&) {
+        currentTrace = RequestTrace();
+        currentTrace.start = std::chrono::steady_clock::now();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context&) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - currentTrace.start;
+        globalMetrics.observeRequest(currentTrace.series, res.code, elapsed.count(), currentTrace.candidates,
+                                     currentTrace.results);
+        for (int st = 0; st < (int)Stage::COUNT; st++) {
+            if (currentTrace.stageSeconds[st] > 0) globalMetrics.observeStage(currentTrace.series, (Stage)st, currentTrace.stageSeconds[st]);
+        }
+
+        if (slowThresholdSeconds > 0 && elapsed.count() >= slowThresholdSeconds) recordSlow(req, res, elapsed.count());
+
+        if (serverTimingAlways || req.get_header_value("X-Server-Timing") == "1") {
+            res.add_header("Server-Timing", serverTiming(currentTrace, elapsed.count()));
+            res.add_header("Timing-Allow-Origin", "*");
+        }
+    }
+};
+
+// index of this worker process with WORKERS > 1, on every /metrics series and the /debug pages
+int workerIndex = 0;
+
+// deepest page a coordinator may ask a shard for
+constexpr size_t MAX_SHARD_K = 5000;
+
 int main() {
-    loadData();
-    crow::SimpleApp app;
+    // SHARD=i/N serves the i-th of N slices of the catalog to a steam_coordinator
+    int shardIndex = 0, shardCount = 1;
+    if (const char* shard = std::getenv("SHARD")) {
+        if (std::sscanf(shard, "%d/%d", &shardIndex, &shardCount) != 2 || shardCount < 1 || shardIndex < 0 ||
+            shardIndex >= shardCount) {
+            std::cerr << "ERROR: SHARD must be <index>/<count>, e.g. 0/2" << std::endl;
+            return 1;
+        }
+    }
+
+    const char* dataDir = std::getenv("DATA_DIR");
+    loadData(dataDir ? dataDir : "", shardIndex, shardCount);
+    buildIndexes();
+    buildFragments();
+
+    const char* staticDir = std::getenv("STATIC_DIR");
+    staticFiles.load(staticDir ? staticDir : "frontend/dist");
+
+    // WORKERS=N forks the worker processes here, once the read-only data is built and before any
+    // thread exists, so they all share the catalog pages. Everything below runs in each worker.
+    int workers = std::max(1, envInt("WORKERS", 1));
+    if (workers > 1) {
+#ifdef __linux__
+        workerIndex = superviseWorkers(workers);
+        if (workerIndex < 0) return 0;
+        globalMetrics.setWorker(workerIndex);
+#else
+        std::cerr << "WARNING: WORKERS needs Linux, serving from one process" << std::endl;
+        workers = 1;
+#endif
+    }
+
+    // Full scans, running and queued on every route together, hold at most half the workers
+    // (SCAN_MAX_WORKERS), so a spike fails fast with 503 instead of starving /search and the cheap
+    // routes. Per route, SCAN_MAX_ACTIVE run and SCAN_MAX_QUEUED wait within that budget.
+    int threads = envInt("WORKER_THREADS", (int)std::max(2u, std::thread::hardware_concurrency() / workers));
+    scanBudget = std::make_unique<AdmissionBudget>(envInt("SCAN_MAX_WORKERS", std::max(1, threads / 2)));
+    int maxActive = envInt("SCAN_MAX_ACTIVE", std::max(1, threads / 2));
+    int maxQueued = envInt("SCAN_MAX_QUEUED", std::max(1, threads / 4));
+    auto maxWait = std::chrono::milliseconds(envInt("SCAN_MAX_WAIT_MS", 250));
+    defaultTimeoutMs = envInt("REQUEST_TIMEOUT_MS", 2000);
+    serverTimingAlways = envInt("SERVER_TIMING", 0) != 0;
+    slowThresholdSeconds = envInt("SLOW_REQUEST_MS", 500) / 1000.0;
+
+    auto makeGate = [&](const char* name) -> AdmissionGate& {
+        admissionGates.push_back(std::make_unique<AdmissionGate>(name, maxActive, maxQueued, maxWait, scanBudget.get()));
+        return *admissionGates.back();
+    };
+    AdmissionGate& globalGate = makeGate("global");
+    AdmissionGate& seedsGate = makeGate("seeds");
+    AdmissionGate& multiGate = makeGate("multi");
+    AdmissionGate& treeGate = makeGate("tree");
+    AdmissionGate& similarityGate = makeGate("similarity");
+
+    // metric series, anything a handler does not claim is counted as "other"
+    globalMetrics.series("other", "");
+    int searchSeries = globalMetrics.series("search", "");
+    int globalSeries = globalMetrics.series("global", "global_weighted");
+    int multiSeries = globalMetrics.series("multi", "multi_feature");
+    int treeSeries = globalMetrics.series("tree", "decision_tree");
+    int staticSeries = globalMetrics.series("static", "");
+    // series by algorithm, built here and only read (find / at) by the handler threads
+    auto seriesByName = [](const char* route, std::initializer_list<const char*> names) {
+        std::unordered_map<std::string, int> byName;
+        for (const char* name : names) byName[name] = globalMetrics.series(route, name);
+        return byName;
+    };
+    const auto seedSeries = seriesByName("seeds", {"centroid", "mean", "max"});
+    const auto similaritySeries = seriesByName("similarity", {"jaccard", "minhash", "cosine", "wjaccard"});
+    const auto shardSeries = seriesByName("shard", {"target", "search", "global", "jaccard", "minhash", "cosine", "wjaccard"});
+
+    crow::App<RequestMetrics> app;
 
     // Search Route
     CROW_ROUTE(app, "/search/<path>")
-    ([&](std::string query) {
+    ([&](const crow::request& req, std::string query) {
+        currentTrace.series = searchSeries;
         query = urlDecode(query);
-    std::transform(query.begin(), query.end(), query.begin(), ::tolower);
+        std::transform(query.begin(), query.end(), query.begin(), ::tolower);
 
-    std::cout << "Searching for: [" << query << "]" << std::endl;
+        if (globalLogger.enabled(LogLevel::INFO) && globalLogger.sampled()) globalLogger.log(LogLevel::INFO, "search", query);
 
-    json results = json::array();
-    int count = 0;
+        bool acceptsGzipBody = acceptsGzip(req.get_header_value("Accept-Encoding"));
+        std::string etag = makeETag(globalDatasetVersion, "search/" + query + (acceptsGzipBody ? ",gzip" : ""));
+        if (etagMatches(req, etag)) return notModified(etag, "Accept-Encoding");
 
-    for (const auto& g : globalGames) {
-        std::string name = getString(g.nameOffset);
-        std::string nameLower = name;
-        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(), ::tolower);
+        std::string& body = responseBuffer();
+        currentTrace.results = searchByName(body, query, 15);
 
-        if (nameLower.find(query) != std::string::npos) {
-            results.push_back({
-                {"id", g.id},
-                {"name", name},
-                {"imageURL", getString(g.imageUrlOffset)}
-            });
-            if (++count >= 15) break;
+        // small suggestion lists stay under COMPRESS_MIN_BYTES and go out as is
+        std::string compressed;
+        if (body.size() >= COMPRESS_MIN_BYTES && acceptsGzipBody) {
+            StageTimer timer(Stage::COMPRESS);
+            compressed = gzipCompress(body);
         }
-    }
-        auto response = crow::response(results.dump());
+        bool gzipped = !compressed.empty();
+
+        auto response = crow::response(gzipped ? std::move(compressed) : body);
         response.add_header("Access-Control-Allow-Origin", "*");
         response.add_header("Content-Type", "application/json; charset=utf-8");
+        response.add_header("Vary", "Accept-Encoding");
+        if (gzipped) response.add_header("Content-Encoding", "gzip");
+        addValidators(response, etag);
         return response;
     });
 
     // Balanced Recommendation
     CROW_ROUTE(app, "/recommend/global/<int>")
-    ([&](int targetId) {
-        auto it = std::find_if(globalGames.begin(), globalGames.end(), [targetId](const CompactGame& g) {
-            return g.id == targetId;
-        });
+    ([&](const crow::request& req, int targetId) {
+        currentTrace.series = globalSeries;
+        currentTrace.appId = (uint32_t)targetId;
+        int targetIdx = findGame(targetId);
+        if (targetIdx < 0) return crow::response(404, "Game not found");
+        const CompactGame& target = globalGames[targetIdx];
+
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
+
+        std::string key = "global/" + std::to_string(target.id) + filterKey(filter);
+        return servePage(req, key, globalGate, [&] {
+            return rankByScore(scanCatalog(filter, {targetIdx}, 0.15f, [&](const CompactGame& g) {
+                return getGlobalScore(target, g);
+            }));
+        }, "global_weighted");
+    });
 
-        if (it == globalGames.end()) return crow::response(404, "Game not found");
-        const CompactGame& target = *it;
+    // "More like these": ?ids=1,2,3&mode=centroid|mean|max, seeds are excluded from the results
+    CROW_ROUTE(app, "/recommend/seeds")
+    ([&](const crow::request& req) {
+        currentTrace.series = seedSeries.at("centroid");
+        const char* rawIds = req.url_params.get("ids");
+        std::vector<uint32_t> ids;
+        if (!rawIds || !parseIdList(rawIds, ids)) return crow::response(400, "Expected ids=<id>,<id>,...");
+        if (ids.size() > MAX_SEEDS) return crow::response(400, "At most " + std::to_string(MAX_SEEDS) + " seeds");
+        if (!ids.empty()) currentTrace.appId = ids.front();
+
+        std::vector<int> seedIndices;
+        for (uint32_t id : ids) {
+            int idx = findGame(id);
+            if (idx >= 0) seedIndices.push_back(idx);
+        }
+        std::sort(seedIndices.begin(), seedIndices.end());
+        seedIndices.erase(std::unique(seedIndices.begin(), seedIndices.end()), seedIndices.end());
+        if (seedIndices.empty()) return crow::response(404, "Game not found");
+
+        const char* rawMode = req.url_params.get("mode");
+        std::string modeName = rawMode ? rawMode : "centroid";
+        SeedMode mode;
+        if (modeName == "centroid") mode = SeedMode::Centroid;
+        else if (modeName == "mean") mode = SeedMode::Mean;
+        else if (modeName == "max") mode = SeedMode::Max;
+        else return crow::response(400, "Unknown mode");
+        currentTrace.series = seedSeries.at(modeName);
+
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
+
+        std::string key = "seeds/" + modeName + "/";
+        for (int idx : seedIndices) key += std::to_string(globalGames[idx].id) + ",";
+        key += filterKey(filter);
+
+        std::string algorithm = "seeds_" + modeName;
+        return servePage(req, key, seedsGate, [&] {
+            SeedProfile profile = buildSeedProfile(seedIndices);
+            if (mode == SeedMode::Centroid) {
+                return rankByScore(scanCatalog(filter, seedIndices, 0.15f, [&](const CompactGame& g) { return getGlobalScore(profile.centroid, g); }));
+            } else if (mode == SeedMode::Mean) {
+                return rankByScore(scanCatalog(filter, seedIndices, 0.15f, [&](const CompactGame& g) { return getSeedMeanScore(profile, g); }));
+            }
+            return rankByScore(scanCatalog(filter, seedIndices, 0.15f, [&](const CompactGame& g) { return getSeedMaxScore(profile, g); }));
+        }, algorithm.c_str());
+    });
 
-        std::vector<std::pair<float, int>> results;
-        for (int i = 0; i < (int)globalGames.size(); i++) {
-            if (globalGames[i].id == targetId) continue;
+    // Multi-feature blend of tags, publisher, developer and review score, ?wTags=&wPub=&wDev=&wReview=
+    CROW_ROUTE(app, "/recommend/multi/<int>")
+    ([&](const crow::request& req, int id) {
+        currentTrace.series = multiSeries;
+        currentTrace.appId = (uint32_t)id;
+        int targetIdx = findGame(id);
+        if (targetIdx < 0) return crow::response(404, "Game not found");
+
+        FeatureWeights weights;
+        bool ok = parseFloatParam(req, "wTags", weights.tags) &&
+                  parseFloatParam(req, "wPub", weights.publishers) &&
+                  parseFloatParam(req, "wDev", weights.developers) &&
+                  parseFloatParam(req, "wReview", weights.reviewScore);
+        if (!ok || weights.tags < 0 || weights.publishers < 0 || weights.developers < 0 || weights.reviewScore < 0) {
+            return crow::response(400, "Invalid weights");
+        }
 
-            float s_jac = getJaccard(target, globalGames[i]);
-            float s_min = getMinHash(target, globalGames[i]);
-            float s_cos = getCosine(target, globalGames[i]);
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
 
-            float globalScore = (s_cos * 0.5f) + (s_min * 0.3f) + (s_jac * 0.2f);
-            if (globalScore > 0.15f) results.push_back({globalScore, i});
-        }
+        std::ostringstream key;
+        key << std::setprecision(9) << "multi/" << globalGames[targetIdx].id << "|w" << weights.tags << ','
+            << weights.publishers << ',' << weights.developers << ',' << weights.reviewScore << filterKey(filter);
 
-        std::sort(results.rbegin(), results.rend());
-
-        json res = json::array();
-        for (int i = 0; i < std::min((int)results.size(), 90); i++) {
-            const auto& g = globalGames[results[i].second];
-
-            json mHash = json::array();
-            for(int j = 0; j < 150; j++) mHash.push_back(g.minHashSignature[j]);
-
-            res.push_back({
-                {"id", g.id},
-                {"name", getString(g.nameOffset)},
-                {"score", roundToTwo(results[i].first)},
-                {"imageURL", getString(g.imageUrlOffset)},
-                {"price", roundToTwo(g.price)},
-                {"algorithm", "global_weighted"},
-                {"tagBits", {g.tagBits[0], g.tagBits[1], g.tagBits[2], g.tagBits[3], g.tagBits[4], g.tagBits[5], g.tagBits[6], g.tagBits[7]}},
-                {"minHash", mHash}
-            });
-        }
-        auto response = crow::response(res.dump());
-        response.add_header("Access-Control-Allow-Origin", "*");
-        response.add_header("Content-Type", "application/json; charset=utf-8");
-        return response;
+        return servePage(req, key.str(), multiGate, [&] {
+            return rankByScore(scanCatalog(filter, {targetIdx}, 0.1f, [&](const CompactGame& g) {
+                return getMultiFeature(targetIdx, gameIndex(g), weights);
+            }));
+        }, "multi_feature");
+    });
+
+    // Decision tree: same developer, same publisher, tag similar, well reviewed, everything else
+    CROW_ROUTE(app, "/recommend/tree/<int>")
+    ([&](const crow::request& req, int id) {
+        currentTrace.series = treeSeries;
+        currentTrace.appId = (uint32_t)id;
+        int targetIdx = findGame(id);
+        if (targetIdx < 0) return crow::response(404, "Game not found");
+
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
+
+        std::string key = "tree/" + std::to_string(globalGames[targetIdx].id) + filterKey(filter);
+        return servePage(req, key, treeGate, [&] { return decisionTree(targetIdx, filter); }, "decision_tree");
     });
 
     // Specific Algorithms
     CROW_ROUTE(app, "/recommend/<string>/<int>")
-    ([&](std::string type, int id) {
-        auto it = std::find_if(globalGames.begin(), globalGames.end(), [id](const CompactGame& g) {
-            return g.id == id;
-        });
+    ([&](const crow::request& req, std::string type, int id) {
+        currentTrace.appId = (uint32_t)id;
+        auto series = similaritySeries.find(type);
+        if (series != similaritySeries.end()) currentTrace.series = series->second;
+        int targetIdx = findGame(id);
+        if (targetIdx < 0) return crow::response(404, "Game not found");
+        const CompactGame& target = globalGames[targetIdx];
+
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
+
+        std::string key = type + "/" + std::to_string(target.id) + filterKey(filter);
+        return servePage(req, key, similarityGate, [&] {
+            // pick the kernel once instead of comparing the type string per candidate
+            ScoredList results;
+            if (type == "jaccard") {
+                results = scanCatalog(filter, {targetIdx}, 0.1f, [&](const CompactGame& g) { return getJaccard(target, g); });
+            } else if (type == "minhash") {
+                results = scanCatalog(filter, {targetIdx}, 0.1f, [&](const CompactGame& g) { return getMinHash(target, g); });
+            } else if (type == "cosine") {
+                results = scanCatalog(filter, {targetIdx}, 0.1f, [&](const CompactGame& g) { return getCosine(target, g); });
+            } else if (type == "wjaccard") {
+                results = scanCatalog(filter, {targetIdx}, 0.1f, [&](const CompactGame& g) { return getWeightedJaccard(targetIdx, gameIndex(g)); });
+            }
+            return rankByScore(std::move(results));
+        }, nullptr);
+    });
 
-        if (it == globalGames.end()) return crow::response(404, "Game not found");
-        const CompactGame& target = *it;
+    // Scatter-gather routes for steam_coordinator, bodies are described in Shard.h. A server without
+    // SHARD answers them too, as the only shard of its catalog.
+
+    // The record of a target game, so shards that do not hold it can score against it
+    CROW_ROUTE(app, "/shard/target/<int>")
+    ([&](int id) {
+        currentTrace.series = shardSeries.at("target");
+        currentTrace.appId = (uint32_t)id;
+        int idx = findGame(id);
+        if (idx < 0) return crow::response(404, "Game not found");
+
+        const TagWeight* votes = nullptr;
+        uint32_t voteCount = 0;
+        if (!globalVoteOffsets.empty()) {
+            votes = &globalVotes[0] + globalVoteOffsets[idx];
+            voteCount = globalVoteOffsets[idx + 1] - globalVoteOffsets[idx];
+        }
+        std::string& body = responseBuffer();
+        encodeShardTarget(body, globalGames[idx], votes, voteCount);
 
-        std::vector<std::pair<float, int>> results;
-        for (int i = 0; i < (int)globalGames.size(); i++) {
-            if (globalGames[i].id == id) continue;
+        return shardResponse(body);
+    });
 
-            float score = 0;
-            if (type == "jaccard") score = getJaccard(target, globalGames[i]);
-            else if (type == "minhash") score = getMinHash(target, globalGames[i]);
-            else if (type == "cosine") score = getCosine(target, globalGames[i]);
+    // This shard's best ?k= results for the target in the body, scored and rendered like /recommend.
+    // Ranked lists are kept in resultStore, so deeper pages of the same query are only sliced.
+    CROW_ROUTE(app, "/shard/recommend/<string>").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req, std::string type) {
+        auto series = shardSeries.find(type);
+        bool known = series != shardSeries.end() && type != "target" && type != "search";
+        if (known) currentTrace.series = series->second;
+
+        ShardTarget target;
+        if (!decodeShardTarget(req.body, target)) return crow::response(400, "Invalid target");
+        const CompactGame& game = target.game;
+        currentTrace.appId = game.id;
+
+        ScanFilter filter;
+        if (!parseFilter(req, filter)) return crow::response(400, "Invalid filter");
+        uint32_t fields;
+        if (!parseFields(req, fields)) return crow::response(400, "Unknown field");
+
+        size_t k = 90;
+        if (const char* rawK = req.url_params.get("k")) {
+            char* end = nullptr;
+            long val = std::strtol(rawK, &end, 10);
+            if (end == rawK || *end != '\0' || val < 1 || val > (long)MAX_SHARD_K) return crow::response(400, "Invalid k");
+            k = (size_t)val;
+        }
 
-            if (score > 0.1) results.push_back({score, i});
+        // only the shard holding the target skips it
+        std::vector<int> exclude;
+        int targetIdx = findGame(game.id);
+        if (targetIdx >= 0) exclude.push_back(targetIdx);
+
+        ScanDeadline deadline{requestDeadline(req)};
+        std::string key = "shard/" + type + "/" + std::to_string(game.id) + filterKey(filter);
+        std::shared_ptr<const ScoredList> results;
+        if (!known) {
+            // an unknown algorithm scores nothing, as /recommend/<algorithm> does on an unsharded server
+            results = std::make_shared<const ScoredList>();
+        } else {
+            StageTimer timer(Stage::LOOKUP);
+            results = resultStore.get(key);
+            globalMetrics.count(results ? Counter::RESULT_STORE_HIT : Counter::RESULT_STORE_MISS);
+        }
+        if (!results) {
+            AdmissionTicket ticket(type == "global" ? globalGate : similarityGate);
+            if (!ticket) return overloaded();
+
+            DeadlineScope scope(deadline);
+            ScoredList scored;
+            if (type == "global") {
+                scored = scanCatalog(filter, exclude, 0.15f, [&](const CompactGame& g) { return getGlobalScore(game, g); });
+            } else if (type == "jaccard" || (type == "wjaccard" && globalVoteOffsets.empty())) {
+                scored = scanCatalog(filter, exclude, 0.1f, [&](const CompactGame& g) { return getJaccard(game, g); });
+            } else if (type == "minhash") {
+                scored = scanCatalog(filter, exclude, 0.1f, [&](const CompactGame& g) { return getMinHash(game, g); });
+            } else if (type == "cosine") {
+                scored = scanCatalog(filter, exclude, 0.1f, [&](const CompactGame& g) { return getCosine(game, g); });
+            } else {
+                const TagWeight* votes = target.votes.data();
+                uint32_t voteTotal = 0;
+                for (const auto& vote : target.votes) voteTotal += vote.weight;
+                scored = scanCatalog(filter, exclude, 0.1f, [&](const CompactGame& g) {
+                    return getWeightedJaccard(votes, votes + target.votes.size(), voteTotal, gameIndex(g));
+                });
+            }
+            results = std::make_shared<const ScoredList>(rankByScore(std::move(scored)));
+            if (!deadline.expired) resultStore.put(key, results);
+        }
+        if (deadline.expired) globalMetrics.count(Counter::PARTIAL_RESULTS);
+
+        const char* algorithm = type == "global" ? "global_weighted" : nullptr;
+        if (!algorithm) fields &= ~FIELD_ALGORITHM;
+        size_t count = std::min(k, results->size());
+        currentTrace.results = count;
+
+        std::string& body = responseBuffer();
+        {
+            StageTimer timer(Stage::SERIALIZE);
+            ShardPageWriter page(body);
+            JsonWriter json(body);
+            MsgPackWriter msgpack(body);
+            bool packed = wantsMsgPack(req);
+            for (size_t i = 0; i < count; i++) {
+                auto [score, idx] = (*results)[i];
+                page.beginHit(score, catalogIndex(idx));
+                if (packed) {
+                    renderResultMsgPack(msgpack, idx, score, algorithm, fields);
+                } else {
+                    renderResult(json, idx, score, algorithm, fields);
+                }
+                page.endHit();
+            }
+            page.finish(deadline.expired ? SHARD_PARTIAL : 0, results->size());
         }
 
-        std::sort(results.rbegin(), results.rend());
+        return shardResponse(body);
+    });
 
-        json res = json::array();
-        for (int i = 0; i < std::min((int)results.size(), 90); i++) {
-            const auto& g = globalGames[results[i].second];
+    // This shard's first /search matches, in catalog order
+    CROW_ROUTE(app, "/shard/search/<path>")
+    ([&](std::string query) {
+        currentTrace.series = shardSeries.at("search");
+        query = urlDecode(query);
+        std::transform(query.begin(), query.end(), query.begin(), ::tolower);
+
+        std::string& body = responseBuffer();
+        ShardPageWriter page(body);
+        JsonWriter w(body);
+        int count = forEachNameMatch(query, 15, [&](int idx) {
+            page.beginHit(0, catalogIndex(idx));
+            renderSearchResult(w, idx);
+            page.endHit();
+        });
+        page.finish(0, (uint64_t)count);
+        currentTrace.results = (uint64_t)count;
 
-            json mHash = json::array();
-            for(int j = 0; j < 150; j++) mHash.push_back(g.minHashSignature[j]);
+        return shardResponse(body);
+    });
 
-            res.push_back({
-                {"id", g.id},
-                {"name", getString(g.nameOffset)},
-                {"imageURL", getString(g.imageUrlOffset)},
-                {"score", roundToTwo(results[i].first)},
-                {"price", roundToTwo(g.price)},
-                {"tagBits", {g.tagBits[0], g.tagBits[1], g.tagBits[2], g.tagBits[3], g.tagBits[4], g.tagBits[5], g.tagBits[6], g.tagBits[7]}},
-                {"minHash", mHash}
-            });
+    // Admission counters per gate
+    CROW_ROUTE(app, "/debug/admission")
+    ([&]() {
+        std::string& body = responseBuffer();
+        JsonWriter w(body);
+        w.raw('{');
+        for (size_t i = 0; i < admissionGates.size(); i++) {
+            auto stats = admissionGates[i]->stats();
+            if (i) w.raw(',');
+            w.key(admissionGates[i]->name.c_str());
+            w.raw("{\"active\":");
+            w.integer(stats.active);
+            w.raw(",\"queued\":");
+            w.integer(stats.queued);
+            w.raw(",\"admitted\":");
+            w.integer(stats.admitted);
+            w.raw(",\"rejectedQueueFull\":");
+            w.integer(stats.rejectedQueueFull);
+            w.raw(",\"rejectedTimeout\":");
+            w.integer(stats.rejectedTimeout);
+            w.raw(",\"rejectedBudget\":");
+            w.integer(stats.rejectedBudget);
+            w.raw('}');
         }
-        auto response = crow::response(res.dump());
-        response.add_header("Access-Control-Allow-Origin", "*");
+        w.raw(",\"budget\":{\"capacity\":");
+        w.integer(scanBudget->capacity);
+        w.raw(",\"inUse\":");
+        w.integer(scanBudget->inUse());
+        w.raw("},\"worker\":");
+        w.integer(workerIndex);
+        w.raw('}');
+
+        auto response = crow::response(body);
+        response.add_header("Content-Type", "application/json; charset=utf-8");
+        response.add_header("Cache-Control", "no-store");
+        return response;
+    });
+
+    // Recent slow requests, newest first, with the stage breakdown in milliseconds
+    CROW_ROUTE(app, "/debug/slow")
+    ([&]() {
+        std::string& body = responseBuffer();
+        JsonWriter w(body);
+        w.raw("{\"worker\":");
+        w.integer(workerIndex);
+        w.raw(",\"thresholdMs\":");
+        w.number(slowThresholdSeconds * 1e3);
+        w.raw(",\"recorded\":");
+        w.integer(slowLog.recorded());
+        w.raw(",\"requests\":[");
+        auto entries = slowLog.snapshot();
+        for (size_t i = 0; i < entries.size(); i++) {
+            const SlowRequest& slow = entries[i];
+            if (i) w.raw(',');
+            w.raw('{');
+            w.key("algorithm");
+            w.string(globalMetrics.algorithm(slow.series).c_str());
+            w.raw(',');
+            w.key("appId");
+            w.integer(slow.appId);
+            w.raw(',');
+            w.key("candidates");
+            w.integer(slow.candidates);
+            w.raw(',');
+            w.key("code");
+            w.integer(slow.code);
+            w.raw(',');
+            w.key("durationMs");
+            w.number(slow.seconds * 1e3);
+            w.raw(',');
+            w.key("results");
+            w.integer(slow.results);
+            w.raw(',');
+            w.key("route");
+            w.string(globalMetrics.route(slow.series).c_str());
+            w.raw(',');
+            w.key("stagesMs");
+            w.raw('{');
+            for (int st = 0; st < (int)Stage::COUNT; st++) {
+                if (st) w.raw(',');
+                w.key(stageName((Stage)st));
+                w.number(slow.stageSeconds[st] * 1e3);
+            }
+            w.raw("},");
+            w.key("timeUs");
+            w.integer((uint64_t)slow.timeUs);
+            w.raw(',');
+            w.key("url");
+            w.string(slow.url.c_str());
+            w.raw('}');
+        }
+        w.raw("]}");
+
+        auto response = crow::response(body);
         response.add_header("Content-Type", "application/json; charset=utf-8");
+        response.add_header("Cache-Control", "no-store");
+        return response;
+    });
+
+    // Prometheus scrape target
+    CROW_ROUTE(app, "/metrics")
+    ([&]() {
+        std::string& body = responseBuffer();
+        globalMetrics.render(body);
+
+        const std::string& worker = globalMetrics.workerLabel();
+        body += "# HELP steam_dataset_games Games loaded into RAM.\n# TYPE steam_dataset_games gauge\n";
+        body += "steam_dataset_games{" + worker + "} " + std::to_string(globalGames.size()) + "\n";
+        body += "# HELP steam_dataset_bytes Bytes held by the loaded dataset.\n# TYPE steam_dataset_bytes gauge\n";
+        body += "steam_dataset_bytes{part=\"games\"," + worker + "} " + std::to_string(globalGames.size() * sizeof(CompactGame)) + "\n";
+        body += "steam_dataset_bytes{part=\"strings\"," + worker + "} " + std::to_string(globalStringPool.size()) + "\n";
+        body += "steam_dataset_bytes{part=\"fragments\"," + worker + "} " + std::to_string(globalFragmentArena.size()) + "\n";
+        body += "steam_dataset_bytes{part=\"tag_votes\"," + worker + "} " + std::to_string(globalVotes.size() * sizeof(TagWeight)) + "\n";
+
+        body += "# HELP steam_admission_active Scans running per gate.\n# TYPE steam_admission_active gauge\n";
+        for (auto& gate : admissionGates) body += "steam_admission_active{gate=\"" + gate->name + "\"," + worker + "} " + std::to_string(gate->stats().active) + "\n";
+        body += "# HELP steam_admission_queued Requests waiting per gate.\n# TYPE steam_admission_queued gauge\n";
+        for (auto& gate : admissionGates) body += "steam_admission_queued{gate=\"" + gate->name + "\"," + worker + "} " + std::to_string(gate->stats().queued) + "\n";
+        body += "# HELP steam_admission_rejected_total Requests turned away per gate.\n# TYPE steam_admission_rejected_total counter\n";
+        for (auto& gate : admissionGates) {
+            auto stats = gate->stats();
+            body += "steam_admission_rejected_total{gate=\"" + gate->name + "\",reason=\"queue_full\"," + worker + "} " + std::to_string(stats.rejectedQueueFull) + "\n";
+            body += "steam_admission_rejected_total{gate=\"" + gate->name + "\",reason=\"timeout\"," + worker + "} " + std::to_string(stats.rejectedTimeout) + "\n";
+            body += "steam_admission_rejected_total{gate=\"" + gate->name + "\",reason=\"budget\"," + worker + "} " + std::to_string(stats.rejectedBudget) + "\n";
+        }
+        body += "# HELP steam_admission_budget_in_use Worker threads held by scans on all gates.\n# TYPE steam_admission_budget_in_use gauge\n";
+        body += "steam_admission_budget_in_use{" + worker + "} " + std::to_string(scanBudget->inUse()) + "\n";
+        body += "# HELP steam_admission_budget_capacity Worker threads scans may hold in total.\n# TYPE steam_admission_budget_capacity gauge\n";
+        body += "steam_admission_budget_capacity{" + worker + "} " + std::to_string(scanBudget->capacity) + "\n";
+
+        body += "# HELP steam_log_dropped_total Log records dropped on full rings.\n# TYPE steam_log_dropped_total counter\n";
+        body += "steam_log_dropped_total{" + worker + "} " + std::to_string(globalLogger.droppedCount()) + "\n";
+
+        auto response = crow::response(body);
+        response.add_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        response.add_header("Cache-Control", "no-store");
         return response;
     });
 
     CROW_CATCHALL_ROUTE(app)
-    ([](const crow::request& req, crow::response& res) {
+    ([&](const crow::request& req, crow::response& res) {
         res.add_header("Access-Control-Allow-Origin", "*");
         res.add_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-        res.add_header("Access-Control-Allow-Headers", "Content-Type");
+        res.add_header("Access-Control-Allow-Headers", "Content-Type, X-Request-Timeout-Ms, X-Server-Timing");
+
+        const StaticAsset* asset = nullptr;
+        bool fallback = false;
+        if (req.method == crow::HTTPMethod::Get || req.method == crow::HTTPMethod::Head) {
+            asset = staticFiles.find(req.url);
+            // client side routes get index.html, but only on navigations that ask for HTML
+            if (!asset && mediaQuality(req.get_header_value("Accept"), "text/html") > 0) {
+                asset = staticFiles.fallback(req.url);
+                fallback = asset != nullptr;
+            }
+        }
 
         if (req.method == crow::HTTPMethod::Options) {
             res.code = 200;
             res.end();
+        } else if (asset) {
+            currentTrace.series = staticSeries;
+            // hashed build output never changes under its name, everything else revalidates
+            res.add_header("Cache-Control", asset->immutable ? "public, max-age=31536000, immutable" : "no-cache");
+            res.add_header("Vary", fallback ? "Accept, Accept-Encoding" : "Accept-Encoding");
+
+            // pick the representation first, its ETag is the one revalidated
+            const std::string& acceptEncoding = req.get_header_value("Accept-Encoding");
+            const std::string* body = &asset->body;
+            const std::string* etag = &asset->etag;
+            const char* encoding = nullptr;
+            if (!asset->brotliBody.empty() && acceptsEncoding(acceptEncoding, "br")) {
+                body = &asset->brotliBody;
+                etag = &asset->brotliEtag;
+                encoding = "br";
+            } else if (!asset->gzipBody.empty() && acceptsGzip(acceptEncoding)) {
+                body = &asset->gzipBody;
+                etag = &asset->gzipEtag;
+                encoding = "gzip";
+            }
+            res.add_header("ETag", *etag);
+
+            if (etagMatches(req, *etag)) {
+                res.code = 304;
+                res.end();
+                return;
+            }
+
+            res.add_header("Content-Type", asset->contentType);
+            if (encoding) res.add_header("Content-Encoding", encoding);
+            res.body = *body;
+            res.code = 200;
+            res.end();
         } else {
             res.code = 404;
             res.end();
@@ -275,7 +965,17 @@ int main() {
     const char* port = std::getenv("PORT");
     uint16_t portNum = port ? (uint16_t)std::stoi(port) : 8080;
 
-    std::cout << "C++ Server online on port " << portNum << std::endl;
-    app.port(portNum).multithreaded().run();
+    // Crow's own per-request logging writes synchronously to std::clog, so only its warnings are kept
+    const char* logFile = std::getenv("LOG_FILE");
+    FILE* logSink = logFile ? std::fopen(logFile, "a") : nullptr;
+    globalLogger.configure(parseLogLevel(std::getenv("LOG_LEVEL"), LogLevel::INFO), (uint32_t)std::max(1, envInt("LOG_SAMPLE", 1)),
+                           logSink ? logSink : stdout);
+    globalLogger.start();
+
+    std::cout << "C++ Server online on port " << portNum;
+    if (workers > 1) std::cout << " (worker " << workerIndex << ")";
+    std::cout << std::endl;
+    app.port(portNum).concurrency(threads).loglevel(crow::LogLevel::Warning).run();
+    globalLogger.stop();
     return 0;
 }
\ No newline at end of file